@@ -0,0 +1,111 @@
+#include "AudioFileLoader.h"
+
+AudioFileLoader::AudioFileLoader()
+{
+    _formats.registerBasicFormats();
+}
+
+juce::AudioBuffer<float> AudioFileLoader::load(const juce::File& file, const Options& options)
+{
+    jassert(options.numSamples >= 0 && options.sampleRate > 0.0);
+
+    auto reader = std::unique_ptr<juce::AudioFormatReader>(_formats.createReaderFor(file));
+
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->numChannels == 0)
+        return {};
+
+    auto start = options.startAtOnset ? findOnset(*reader) : juce::int64(0);
+    auto needsResampling = reader->sampleRate != options.sampleRate;
+    auto numSamples = options.numSamples;
+
+    if (numSamples == 0)
+    {
+        auto numRemaining = double(reader->lengthInSamples - start) * options.sampleRate / reader->sampleRate;
+        numSamples = int(std::ceil(juce::jmin(numRemaining, maxWholeFileTime * options.sampleRate)));
+    }
+
+    if (numSamples <= 0)
+        return {};
+
+    // Enough of the source to cover the window at its own rate
+    auto numSource = int(std::ceil(numSamples * reader->sampleRate / options.sampleRate));
+
+    if (needsResampling)
+        numSource += resamplerMargin;
+
+    auto numChannels = options.mono ? 1 : int(reader->numChannels);
+    juce::AudioBuffer<float> source{ int(reader->numChannels), numSource };
+
+    // Reads past the end of the file come back as zeros
+    reader->read(&source, 0, numSource, start, true, true);
+
+    if (options.mono && source.getNumChannels() > 1)
+    {
+        for (int j = 1; j < source.getNumChannels(); j++)
+            source.addFrom(0, 0, source, j, 0, numSource);
+
+        source.applyGain(0, 0, numSource, 1.0f / float(source.getNumChannels()));
+        source.setSize(1, numSource, true);
+    }
+
+    juce::AudioBuffer<float> result{ numChannels, numSamples };
+
+    if (needsResampling)
+    {
+        auto resampler = _resamplers->acquire(reader->sampleRate, options.sampleRate, r8b::Quality::high, numChannels);
+        resampler->process(source, result);
+    }
+    else
+    {
+        for (int j = 0; j < numChannels; j++)
+            result.copyFrom(j, 0, source, j, 0, numSamples);
+    }
+
+    return result;
+}
+
+juce::String AudioFileLoader::getWildcardForAllFormats() const
+{
+    return _formats.getWildcardForAllFormats();
+}
+
+juce::int64 AudioFileLoader::findOnset(juce::AudioFormatReader& reader)
+{
+    auto numToSearch = juce::jmin(reader.lengthInSamples, juce::int64(maxOnsetSearchTime * reader.sampleRate));
+    auto numChannels = int(reader.numChannels);
+
+    // Read a block of hops at a time, stopping as soon as the onset turns up
+    static constexpr int hopsPerBlock = 32;
+    juce::AudioBuffer<float> block{ numChannels, onsetHopSize * hopsPerBlock };
+
+    double sumOfLevels = 0.0;
+    int numHops = 0;
+
+    for (juce::int64 position = 0; position < numToSearch; position += block.getNumSamples())
+    {
+        reader.read(&block, 0, block.getNumSamples(), position, true, true);
+
+        for (int h = 0; h < hopsPerBlock; h++)
+        {
+            auto level = 0.0f;
+
+            for (int j = 0; j < numChannels; j++)
+                level = juce::jmax(level, block.getRMSLevel(j, h * onsetHopSize, onsetHopSize));
+
+            // Compared with the average level so far, so a steady noise floor isn't an onset
+            auto floor = numHops > 0 ? float(sumOfLevels / numHops) : 0.0f;
+
+            if (level > onsetThreshold && level > onsetRatio * floor)
+            {
+                // One hop early, to keep the attack whole
+                auto hopStart = position + h * onsetHopSize;
+                return juce::jmax(juce::int64(0), hopStart - onsetHopSize);
+            }
+
+            sumOfLevels += level;
+            numHops++;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <resample.h>
+
+/**
+    Reads a fixed-length window from an audio file, at a fixed sample rate.
+
+    Only the part of the file that ends up in the window is decoded, plus a
+    little after it for the resampler's filter, so the size of the file
+    doesn't matter. Any format AudioFormatManager's basic formats cover can
+    be read. The window can start at the file's first onset rather than its
+    first sample, skipping leading silence or noise, and can be mixed to mono.
+*/
+class AudioFileLoader
+{
+public:
+    static constexpr double maxWholeFileTime{ 60.0 };
+
+    struct Options
+    {
+        // Or 0 for the rest of the file, up to maxWholeFileTime
+        int numSamples{ 21000 };
+        double sampleRate{ 44.1e3 };
+        bool startAtOnset{ false };
+        bool mono{ true };
+    };
+
+    AudioFileLoader();
+    ~AudioFileLoader() = default;
+
+    // Exactly numSamples long, zero-padded past the end of the file, or empty if the file can't be read or is empty
+    juce::AudioBuffer<float> load(const juce::File& file, const Options& options);
+
+    // For file choosers, e.g. "*.wav;*.flac"
+    juce::String getWildcardForAllFormats() const;
+
+private:
+    // Onsets are searched for in hops of this many samples, over at most maxOnsetSearchTime
+    static constexpr int onsetHopSize{ 128 };
+    static constexpr double maxOnsetSearchTime{ 5.0 };
+
+    // A hop is an onset once it's this much louder than the hops before it, and above onsetThreshold
+    static constexpr float onsetRatio{ 4.0f };
+    static constexpr float onsetThreshold{ 1.0e-3f };
+
+    // Source samples decoded after the window so that its end resamples as it would in context
+    static constexpr int resamplerMargin{ 1024 };
+
+    static juce::int64 findOnset(juce::AudioFormatReader& reader);
+
+    juce::AudioFormatManager _formats;
+    juce::SharedResourcePointer<r8b::ResamplerPool> _resamplers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioFileLoader)
+};
@@ -35,42 +35,90 @@ public:
         mInputNames = GetInputNames();
         mOutputNames = GetOutputNames();
 
+        // Models exported before the embedding was added only have the class output
+        if (mOutputShapes.size() > 1)
+            mEmbeddingSize = static_cast<size_t>(mOutputShapes[1].back());
+
         // Fix the input/output shapes so that they are (1, inputSize)
-        mInputShapes[0] = {1, inputSize};
-        mOutputShapes[0] = {1, numClasses};
+        SetBatchSize(1);
+
+        // Prime onnxruntime, so that it doesn't allocate in the RT Thread
+        //RunInference();
+    }
+
+    void process(const float *input, size_t *classification, float *confidence) {
+        processBatch(input, 1, classification, confidence);
+        // Kick,Hat, Snare
+    }
 
-        mXScratch.resize(inputSize);
-        mYScratch.resize(numClasses);
+    // Classifies batchSize inputs of inputSize samples each, laid out one after another, in one model call
+    void processBatch(const float *input, size_t batchSize, size_t *classifications, float *confidences) {
+        SetBatchSize(batchSize);
 
+        memcpy(mXScratch.data(), input, mXScratch.size() * sizeof(float));
+        RunInference();
+
+        for (size_t b = 0; b < batchSize; b++) {
+            auto scores = mYScratch.begin() + static_cast<std::ptrdiff_t>(b * numClasses);
+            auto argMax = std::distance(scores, std::max_element(scores, scores + numClasses));
+
+            classifications[b] = static_cast<size_t>(argMax);
+            confidences[b] = scores[argMax];
+        }
+    }
+
+    // Length of one embedding, or 0 if the model doesn't output one
+    int getEmbeddingSize() const {
+        return static_cast<int>(mEmbeddingSize);
+    }
+
+    // Penultimate layer activations from the last call, one per input one after another.
+    // Similar drums are close together.
+    const std::vector<float> &getEmbedding() const {
+        return mEmbedding;
+    }
+
+private:
+    void SetBatchSize(size_t batchSize) {
+        if (batchSize == mBatchSize)
+            return;
+
+        mBatchSize = batchSize;
+        mInputShapes[0] = {static_cast<int64_t>(batchSize), inputSize};
+        mOutputShapes[0] = {static_cast<int64_t>(batchSize), numClasses};
+
+        mXScratch.resize(batchSize * inputSize);
+        mYScratch.resize(batchSize * numClasses);
+        mEmbedding.resize(batchSize * mEmbeddingSize);
+
+        // The tensors refer to the scratch buffers, which may have moved
+        mInputTensors.clear();
         mInputTensors.push_back(
                 Ort::Value::CreateTensor<float>(info, mXScratch.data(), mXScratch.size(), mInputShapes[0].data(),
                                                 mInputShapes[0].size()));
         mInputTensors.push_back(
                 Ort::Value::CreateTensor<double>(info, sigVal.data(), sigVal.size(), mInputShapes[1].data(),
                                                  mInputShapes[1].size()));
+
+        mOutputTensors.clear();
         mOutputTensors.push_back(
                 Ort::Value::CreateTensor<float>(info, mYScratch.data(), mYScratch.size(), mOutputShapes[0].data(),
                                                 mOutputShapes[0].size()));
 
-        // Prime onnxruntime, so that it doesn't allocate in the RT Thread
-        //RunInference();
-    }
-
-    void process(const float *input, size_t *classification, float *confidence) {
-        memcpy(mXScratch.data(), input, inputSize * sizeof(float));
-        RunInference();
-
-        memcpy(classification, &argMax, 1 * sizeof(int));
-        memcpy(confidence, &confidenceVal, 1 * sizeof(float));
-        // Kick,Hat, Snare
+        if (mEmbeddingSize > 0) {
+            mOutputShapes[1] = {static_cast<int64_t>(batchSize), static_cast<int64_t>(mEmbeddingSize)};
+            mOutputTensors.push_back(
+                    Ort::Value::CreateTensor<float>(info, mEmbedding.data(), mEmbedding.size(),
+                                                    mOutputShapes[1].data(), mOutputShapes[1].size()));
+        }
     }
 
-private:
     void RunInference() {
         // Initialize variables
         std::fill(mYScratch.begin(), mYScratch.end(), 0.0f);
         const char *inputNamesCstrs[] = {mInputNames[0].c_str(), mInputNames[1].c_str()};
-        const char *outputNamesCstrs[] = {mOutputNames[0].c_str()};
+        const char *outputNamesCstrs[] = {mOutputNames[0].c_str(),
+                                          mOutputNames.size() > 1 ? mOutputNames[1].c_str() : nullptr};
 
         sigVal = {static_cast<double>(0)};
 
@@ -78,9 +126,6 @@ private:
         mSession->Run(mRunOptions,
                       inputNamesCstrs, mInputTensors.data(), mInputTensors.size(),
                       outputNamesCstrs, mOutputTensors.data(), mOutputTensors.size());
-
-        argMax = static_cast<size_t>(std::distance(mYScratch.begin(), max_element(mYScratch.begin(), mYScratch.end())));
-        confidenceVal = mYScratch[argMax];
         // Kick,Snare,Hat
     }
 
@@ -130,6 +175,7 @@ private:
     std::vector<float> mXScratch;       // noise input
     std::vector<float> mYScratch;       // audio output
     std::vector<double> sigVal = {0.0}; // sigma input
+    std::vector<float> mEmbedding;      // embedding output
 
     std::vector<Ort::Value> mInputTensors;
     std::vector<std::vector<int64_t>> mInputShapes;
@@ -140,6 +186,6 @@ private:
     std::vector<std::string> mInputNames;
     std::vector<std::string> mOutputNames;
 
-    size_t argMax;
-    float confidenceVal;
+    size_t mBatchSize = 0;
+    size_t mEmbeddingSize = 0;
 };
@@ -1,5 +1,19 @@
 #include "Components.h"
 
+void showExportFormatMenu(juce::Component& target, std::function<void(SampleExporter::Format)> onChosen)
+{
+	juce::PopupMenu menu;
+
+	for (auto format : { SampleExporter::Format::int24, SampleExporter::Format::float32 })
+		menu.addItem(int(format) + 1, SampleExporter::getName(format));
+
+	menu.showMenuAsync(juce::PopupMenu::Options().withTargetComponent(&target), [onChosen](int result)
+	{
+		if (result > 0)
+			onChosen(static_cast<SampleExporter::Format>(result - 1));
+	});
+}
+
 SamplePad::SamplePad(int midiNoteNumber) : _midiNote(midiNoteNumber)
 {
 	_noteName = juce::MidiMessage::getMidiNoteName(midiNoteNumber, true, true, 4);
@@ -74,16 +88,20 @@ void SamplePad::setLabel(const juce::String& label, const juce::Colour& col)
 }
 
 
-SampleKeyboard::SampleKeyboard(int baseNote, int numNotes, juce::MidiKeyboardState& midiKeyboardState, int midiChannel) 
-	: _baseMidiNote(baseNote), _midiState(midiKeyboardState), _midiChannel(midiChannel)
+SampleKeyboard::SampleKeyboard(int baseNote, int numNotes, NoteState& noteState, int midiChannel) 
+	: _baseMidiNote(baseNote), _noteState(noteState), _midiChannel(midiChannel)
 {
 	for (int i = 0; i < numNotes; i++)
 	{
 		auto note = _notes.add(new SamplePad(baseNote + i));
 		note->addMouseListener(this, false);
 		addAndMakeVisible(note);
+
+		_lastNumHits.push_back(_noteState.getNumHits(baseNote + i));
 	}
 
+	_lastNumChanges = _noteState.getNumChanges() - 1;
+
 	updateSelectedNote();
 
 	startTimer(_timerLengthMs);
@@ -120,12 +138,32 @@ void SampleKeyboard::setNoteLabel(int idx, const juce::String& label, const juce
 
 void SampleKeyboard::timerCallback()
 {
+	// Nothing has started or stopped, and no short hit is waiting to be cleared
+	auto numChanges = _noteState.getNumChanges();
+
+	if (numChanges == _lastNumChanges && !_hasHitsShowing)
+		return;
+
+	_lastNumChanges = numChanges;
+	_hasHitsShowing = false;
+
+	auto snapshot = _noteState.getSnapshot();
+
 	for (int i = 0; i < _notes.size(); i++)
 	{
-		auto noteState = _midiState.isNoteOn(_midiChannel, _baseMidiNote + i);
-		_notes[i]->setNoteOn(noteState);
+		auto note = _baseMidiNote + i;
+		auto numHits = _noteState.getNumHits(note);
+		auto wasHit = numHits != _lastNumHits[i];
+		_lastNumHits[i] = numHits;
+
+		// A hit that has already ended still shows until the next poll
+		auto isOn = snapshot.isNoteOn(note);
+		_hasHitsShowing |= wasHit && !isOn;
 
-		if (noteState)
+		// Pads only repaint when this changes
+		_notes[i]->setNoteOn(isOn || wasHit);
+
+		if (wasHit)
 			setSelectedNote(i);
 	}
 }
@@ -136,7 +174,7 @@ void SampleKeyboard::mouseDown(const juce::MouseEvent& e)
 	{
 		if (_notes[i] == e.eventComponent)
 		{
-			_midiState.noteOn(_midiChannel, i + _baseMidiNote, 1.0f);
+			_noteState.noteOn(_midiChannel, i + _baseMidiNote, 1.0f);
 			
 			setSelectedNote(i);
 			break;
@@ -148,7 +186,7 @@ void SampleKeyboard::mouseUp(const juce::MouseEvent& e)
 {
 	for (int i = 0; i < _notes.size(); i++)
 		if (_notes[i] == e.eventComponent)
-			_midiState.noteOff(_midiChannel, i + _baseMidiNote, 1.0f);
+			_noteState.noteOff(_midiChannel, i + _baseMidiNote);
 }
 
 void SampleKeyboard::updateSelectedNote()
@@ -159,7 +197,6 @@ void SampleKeyboard::updateSelectedNote()
 
 
 ParameterView::ParameterView(SoundWithParameters* sound) 
-	: _cache(5), _thumbnail(512, _afm, _cache)
 {
 	// Set up sliders
 	auto initLinearSlider = [this](juce::Slider& s)
@@ -205,21 +242,24 @@ ParameterView::ParameterView(SoundWithParameters* sound)
 	_saveButton.setButtonText("Save");
 	_saveButton.onClick = [=]
 	{
-        auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting;
-        auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
-
-        _chooser = std::make_unique<juce::FileChooser>("Save sample", defaultPath, "*.wav");
-        
-        _chooser->launchAsync(flags, [=](const juce::FileChooser& chooser) {
-            auto f = chooser.getResult();
-            
-            if (f == juce::File())
-                return;
-            
-			auto sample = sound->getSample();
-            if (sample != nullptr)
-        		Utils::writeWavFile(sample->data, sample->sampleRate, f);
-        });
+		showExportFormatMenu(_saveButton, [=](SampleExporter::Format format)
+		{
+			auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::warnAboutOverwriting;
+			auto defaultFile = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory).getChildFile("Sample.wav");
+
+			// The chooser adds the extension, so that its overwrite warning is for the file actually written
+			_chooser = std::make_unique<juce::FileChooser>("Save sample", defaultFile, "*.wav");
+
+			_chooser->launchAsync(flags, [=](const juce::FileChooser& chooser) {
+				auto f = chooser.getResult();
+
+				if (f == juce::File())
+					return;
+
+				if (onSave)
+					onSave(f, format);
+			});
+		});
 	};
 	addAndMakeVisible(_saveButton);
 
@@ -231,27 +271,67 @@ ParameterView::ParameterView(SoundWithParameters* sound)
 	};
 	addAndMakeVisible(_clearButton);
 
+	_similarButton.setButtonText("Similar");
+	_similarButton.setTooltip("Find drums in the library that sound like this one");
+	_similarButton.onClick = [this]
+	{
+		if (onFindSimilar)
+			onFindSimilar();
+	};
+	addAndMakeVisible(_similarButton);
+
+	// Ids are the group plus one, as a ComboBox id can't be 0
+	_chokeBox.addItem("No choke", 1);
+	for (int g = 1; g <= DrumSynthesiser::maxNumChokeGroups; g++)
+		_chokeBox.addItem("Choke " + juce::String(g), g + 1);
+
+	_chokeBox.setSelectedId(1, juce::dontSendNotification);
+	_chokeBox.setTooltip("Pads in the same choke group cut each other off");
+	_chokeBox.onChange = [this]
+	{
+		if (onChokeGroupChange)
+			onChokeGroupChange(_chokeBox.getSelectedId() - 1);
+	};
+	addAndMakeVisible(_chokeBox);
+
 	sound->sampleChanged = [=]
 	{
-		auto sample = sound->getSample();
-		if (sample != nullptr)
+		_sample = sound->getSample();
+		if (_sample != nullptr)
 		{
 			_saveButton.setVisible(true);
 			_clearButton.setVisible(true);
-			_thumbnail.setSource(&sample->data, sample->sampleRate, 0);
+			_similarButton.setVisible(true);
+
+			// Peaks are built once per sample in the background, then drawn from
+			Sample::preparePeaks(_sample, *_peaksPool, [safe = juce::Component::SafePointer<ParameterView>(this)]
+			{
+				if (safe != nullptr)
+					safe->repaint();
+			});
 			repaint();
 		}
 		else
 		{
 			_saveButton.setVisible(false);
 			_clearButton.setVisible(false);
-			_thumbnail.clear();
+			_similarButton.setVisible(false);
 			repaint();
 		}
 	};
 	sound->sampleChanged();
 }
 
+void ParameterView::setSimilarEnabled(bool enabled)
+{
+	_similarButton.setEnabled(enabled);
+}
+
+void ParameterView::setChokeGroup(int group)
+{
+	_chokeBox.setSelectedId(group + 1, juce::dontSendNotification);
+}
+
 void ParameterView::paint(juce::Graphics& g)
 {
 	if (auto laf = dynamic_cast<CustomLookAndFeel*>(&getLookAndFeel()))
@@ -261,15 +341,18 @@ void ParameterView::paint(juce::Graphics& g)
 		laf->drawControlPanel(g, _knobBounds);
 	}
 
-	if (_thumbnail.getNumChannels() > 0)
+	if (_sample != nullptr)
 	{
-        g.setColour(CustomLookAndFeel::Palette::light1);
-        _thumbnail.drawChannels(g,
-                                _thumbnailBounds,
-                                0.0,
-                                _thumbnail.getTotalLength(),
-                                1.0f);
-	}	
+		if (auto peaks = _sample->getPeaks())
+		{
+			g.setColour(CustomLookAndFeel::Palette::light1);
+			peaks->drawChannels(g,
+			                    _thumbnailBounds,
+			                    0,
+			                    peaks->getNumSamples(),
+			                    1.0f);
+		}
+	}
 	else
 	{
         g.setColour(CustomLookAndFeel::Palette::light1);
@@ -291,6 +374,8 @@ void ParameterView::resized()
 	thumbnailButtonBounds = thumbnailButtonBounds.removeFromRight(50);
 	_saveButton.setBounds(thumbnailButtonBounds.removeFromTop(20));
 	_clearButton.setBounds(thumbnailButtonBounds.removeFromTop(20));
+	_similarButton.setBounds(thumbnailButtonBounds.removeFromTop(20));
+	_chokeBox.setBounds(_thumbnailBounds.withTrimmedTop(_thumbnailBounds.getHeight() - 20).removeFromRight(90));
 
 	// Envelope sliders
 	auto adsrSliderWidth = _adsrBounds.getWidth() / 4;
@@ -317,3 +402,116 @@ void ParameterView::resized()
 		_labels[i].setBounds(labelBounds);
 	}
 }
+
+LibraryBrowser::LibraryBrowser(DrumLibrary& library) : _library(library)
+{
+	// Ids are the DrumType values, which start from one
+	_typeBox.addItem("Kick", int(DrumType::kick));
+	_typeBox.addItem("Snare", int(DrumType::snare));
+	_typeBox.addItem("Hat", int(DrumType::hat));
+	_typeBox.onChange = [this] { showType(static_cast<DrumType>(_typeBox.getSelectedId())); };
+	addAndMakeVisible(_typeBox);
+
+	_list.setModel(this);
+	_list.setRowHeight(28);
+	_list.setColour(juce::ListBox::backgroundColourId, CustomLookAndFeel::Palette::dark);
+	addAndMakeVisible(_list);
+}
+
+void LibraryBrowser::resized()
+{
+	auto bounds = getLocalBounds().reduced(4);
+	_typeBox.setBounds(bounds.removeFromTop(20).removeFromLeft(100));
+	bounds.removeFromTop(4);
+	_list.setBounds(bounds);
+}
+
+void LibraryBrowser::showType(DrumType drumType)
+{
+	// Looked up again each time, as drums are added while the browser is hidden
+	showEntries(_library.findEntries(drumType), {});
+	_typeBox.setSelectedId(int(drumType), juce::dontSendNotification);
+}
+
+void LibraryBrowser::showEntries(const juce::Array<int>& entries, const juce::String& title)
+{
+	// Choosing a type from the box goes back to listing by type
+	if (title.isNotEmpty())
+		_typeBox.setText(title, juce::dontSendNotification);
+
+	_entries = entries;
+	_thumbnails.clear();
+	_list.deselectAllRows();
+	_list.updateContent();
+	_list.repaint();
+}
+
+int LibraryBrowser::getNumRows()
+{
+	return _entries.size();
+}
+
+void LibraryBrowser::paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected)
+{
+	if (!juce::isPositiveAndBelow(rowNumber, _entries.size()))
+		return;
+
+	if (rowIsSelected)
+		g.fillAll(CustomLookAndFeel::Palette::highlight1.withAlpha(0.5f));
+
+	auto entry = _library.getEntry(_entries[rowNumber]);
+	auto bounds = juce::Rectangle<int>(width, height).reduced(6, 0);
+
+	// Similar drums can be of any type, so each row says which
+	juce::String typeName;
+	switch (entry.drumType)
+	{
+		case DrumType::kick: 	typeName = "Kick"; 	break;
+		case DrumType::snare: 	typeName = "Snare"; break;
+		case DrumType::hat: 	typeName = "Hat"; 	break;
+		default: 				break;
+	}
+
+	g.setColour(CustomLookAndFeel::Palette::light1);
+	g.setFont(CustomLookAndFeel::getFont().withHeight(juce::jmin(14.0f, float(height) * 0.6f)));
+	g.drawText(typeName, bounds.removeFromLeft(50), juce::Justification::centredLeft);
+
+	// Drawn once its peaks are ready, the row being repainted then
+	auto thumbnailBounds = bounds.removeFromLeft(120).reduced(0, 2);
+	bounds.removeFromLeft(10);
+
+	if (auto sample = getThumbnail(_entries[rowNumber]))
+		if (auto peaks = sample->getPeaks())
+			peaks->drawChannels(g, thumbnailBounds, 0, peaks->getNumSamples(), 1.0f);
+
+	g.drawText(juce::Time(entry.time).formatted("%Y-%m-%d %H:%M:%S"), bounds, juce::Justification::centredLeft);
+	g.drawText(juce::String(juce::roundToInt(entry.confidence * 100.0f)) + "%", bounds, juce::Justification::centredRight);
+}
+
+Sample::Ptr LibraryBrowser::getThumbnail(int entry)
+{
+	auto found = _thumbnails.find(entry);
+
+	if (found != _thumbnails.end())
+		return found->second;
+
+	auto sample = _library.load(entry).sample;
+	_thumbnails[entry] = sample;
+
+	if (sample != nullptr)
+	{
+		Sample::preparePeaks(sample, *_peaksPool, [safe = juce::Component::SafePointer<juce::ListBox>(&_list)]
+		{
+			if (safe != nullptr)
+				safe->repaint();
+		});
+	}
+
+	return sample;
+}
+
+void LibraryBrowser::listBoxItemClicked(int row, const juce::MouseEvent&)
+{
+	if (juce::isPositiveAndBelow(row, _entries.size()) && onEntryChosen)
+		onEntryChosen(_entries[row]);
+}
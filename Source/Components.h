@@ -1,9 +1,16 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "DrumLibrary.h"
+#include "DrumSynthesiser.h"
+#include "NoteState.h"
 #include "Sampler.h"
+#include "SampleExporter.h"
 #include "LookAndFeel.h"
 
+// Offers the export formats in a menu by target, and calls onChosen with the one picked, if any
+void showExportFormatMenu(juce::Component& target, std::function<void(SampleExporter::Format)> onChosen);
+
 class SamplePad : public juce::Component
 {
 public:
@@ -34,7 +41,7 @@ class SampleKeyboard : public juce::Component, public juce::Timer
 public:
 	SampleKeyboard(int baseNote, 
 				   int numNotes, 
-			       juce::MidiKeyboardState& midiKeyboardState, 
+			       NoteState& noteState, 
 				   int midiChannel = 1);
 
 	~SampleKeyboard() override = default;
@@ -55,11 +62,16 @@ private:
 
 	const int _midiChannel;
 	const int _baseMidiNote;
-	juce::MidiKeyboardState& _midiState;
+	NoteState& _noteState;
 
 	juce::OwnedArray<SamplePad> _notes;
 	int _lastNoteIndex{ 0 };
 
+	// Published counts as of the last poll, to spot what has changed since
+	juce::uint32 _lastNumChanges{ 0 };
+	std::vector<juce::uint32> _lastNumHits;
+	bool _hasHitsShowing{ false };
+
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleKeyboard)
 };
 
@@ -74,19 +86,70 @@ public:
 	void paint(juce::Graphics& g) override;
 	void resized() override;
 
+	// The group lives in the synth, so the editor passes it in and handles changes, 0 being no group
+	void setChokeGroup(int group);
+	std::function<void(int)> onChokeGroupChange{ nullptr };
+
+	// Asks for library drums like this pad's, which the editor finds and shows. Disabled while
+	// other work uses the models.
+	void setSimilarEnabled(bool enabled);
+	std::function<void()> onFindSimilar{ nullptr };
+
+	// Called with the file chosen by Save, which the editor writes the pad's drum to
+	std::function<void(const juce::File&, SampleExporter::Format)> onSave{ nullptr };
+
 private:
 	std::array<juce::Slider, numParameters> _sliders;
 	std::array<std::unique_ptr<juce::SliderParameterAttachment>, numParameters> _attachments;
 	std::array<juce::Label, numParameters> _labels;
 
-	juce::AudioFormatManager _afm;
-	juce::AudioThumbnailCache _cache;
-	juce::AudioThumbnail _thumbnail;
+	// Held so that its peaks outlive any change of sample until the next repaint
+	Sample::Ptr _sample;
+	juce::SharedResourcePointer<juce::ThreadPool> _peaksPool;
 
 	juce::Rectangle<int> _thumbnailBounds, _adsrBounds, _knobBounds;
 
-	juce::TextButton _clearButton, _saveButton;
+	juce::TextButton _clearButton, _saveButton, _similarButton;
+	juce::ComboBox _chokeBox;
 	std::unique_ptr<juce::FileChooser> _chooser;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterView)
 };
+
+// Lists the drums in the library by type, and calls onEntryChosen with the index of the one clicked
+class LibraryBrowser : public juce::Component, private juce::ListBoxModel
+{
+public:
+	LibraryBrowser(DrumLibrary& library);
+	~LibraryBrowser() override = default;
+
+	void resized() override;
+
+	// Lists the library's drums of one type, newest first
+	void showType(DrumType drumType);
+
+	// Lists the given entries in order, under title in place of a type
+	void showEntries(const juce::Array<int>& entries, const juce::String& title);
+
+	std::function<void(int)> onEntryChosen{ nullptr };
+
+private:
+	int getNumRows() override;
+	void paintListBoxItem(int rowNumber, juce::Graphics& g, int width, int height, bool rowIsSelected) override;
+	void listBoxItemClicked(int row, const juce::MouseEvent& e) override;
+
+	// The entry's drum, which refers into the library file, with its peaks built in the background on first use
+	Sample::Ptr getThumbnail(int entry);
+
+	DrumLibrary& _library;
+
+	juce::ComboBox _typeBox;
+	juce::ListBox _list;
+	juce::Array<int> _entries;
+
+	// Kept for the entries listed, so each row's peaks are only built once
+	std::map<int, Sample::Ptr> _thumbnails;
+	juce::SharedResourcePointer<juce::ThreadPool> _peaksPool;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LibraryBrowser)
+};
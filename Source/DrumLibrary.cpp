@@ -0,0 +1,441 @@
+#include "DrumLibrary.h"
+#include "UnetModelInference.h"
+
+static_assert(DrumLibrary::recordLength == UnetModelInference::outputSize, "Library records must hold one generated drum");
+
+namespace
+{
+    constexpr int indexFileMagic = 0x43524c42; // "CRLB"
+    constexpr int indexFileVersion = 2;
+    constexpr int indexHeaderSize = 3 * sizeof(int);
+
+    // Version 1 entries held only the type, confidence, seed and date, and are upgraded when read
+    constexpr int indexEntrySizeV1 = 3 * sizeof(int) + sizeof(juce::int64);
+
+    // Followed by the hash, audible length, and the RMS then the peak of every level block
+    constexpr int numLevelBlocks = (DrumLibrary::recordLength + Sample::Levels::blockSize - 1) / Sample::Levels::blockSize;
+    constexpr int indexEntrySize = indexEntrySizeV1 + sizeof(juce::int64) + sizeof(int) + 2 * numLevelBlocks * sizeof(float);
+
+    constexpr int embeddingsFileMagic = 0x4352454d; // "CREM"
+    constexpr int embeddingsFileVersion = 1;
+    constexpr int embeddingsHeaderSize = 3 * sizeof(int);
+}
+
+DrumLibrary::DrumLibrary()
+    : DrumLibrary(juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                      .getChildFile(JucePlugin_Name)
+                      .getChildFile("Library"))
+{
+}
+
+DrumLibrary::DrumLibrary(const juce::File& directory)
+    : _recordsFile(directory.getChildFile("drums.dat")),
+      _indexFile(directory.getChildFile("drums.idx")),
+      _embeddingsFile(directory.getChildFile("drums.emb"))
+{
+    directory.createDirectory();
+    readIndex();
+    readEmbeddings();
+}
+
+int DrumLibrary::getNumEntries() const
+{
+    const juce::ScopedLock sl(_lock);
+    return int(_entries.size());
+}
+
+DrumLibrary::Entry DrumLibrary::getEntry(int index) const
+{
+    const juce::ScopedLock sl(_lock);
+    jassert(juce::isPositiveAndBelow(index, int(_entries.size())));
+
+    return _entries[size_t(index)];
+}
+
+juce::Array<int> DrumLibrary::findEntries(DrumType drumType) const
+{
+    const juce::ScopedLock sl(_lock);
+    juce::Array<int> result;
+
+    // Entries are only ever appended, so later ones are newer
+    for (auto i = int(_entries.size()); --i >= 0;)
+        if (_entries[size_t(i)].drumType == drumType)
+            result.add(i);
+
+    return result;
+}
+
+int DrumLibrary::findEntry(juce::int64 hash) const
+{
+    const juce::ScopedLock sl(_lock);
+
+    for (auto i = int(_analyses.size()); --i >= 0;)
+        if (_analyses[size_t(i)].hash == hash)
+            return i;
+
+    return -1;
+}
+
+int DrumLibrary::add(const juce::AudioBuffer<float>& data, const Entry& entry, const std::vector<float>& embedding)
+{
+    jassert(data.getNumChannels() == 1 && data.getNumSamples() == recordLength);
+
+    if (data.getNumChannels() != 1 || data.getNumSamples() != recordLength)
+        return -1;
+
+    const juce::ScopedLock sl(_lock);
+
+    // Records are written before their index entry, so a failed write leaves at most an unused record
+    {
+        juce::FileOutputStream stream{ _recordsFile };
+
+        if (!stream.openedOk())
+            return -1;
+
+        // Appends after the last whole record, dropping any partial one
+        stream.setPosition(juce::int64(_entries.size() * recordSizeInBytes));
+        stream.truncate();
+
+        const float guard[Sample::numGuardSamples] = {};
+        stream.write(guard, sizeof(guard));
+        stream.write(data.getReadPointer(0), size_t(recordLength) * sizeof(float));
+        stream.write(guard, sizeof(guard));
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return -1;
+    }
+
+    auto analysis = analyse(data);
+
+    if (!writeIndexEntry(entry, analysis))
+        return -1;
+
+    _entries.push_back(entry);
+    _analyses.push_back(std::move(analysis));
+    _mapping = nullptr;
+
+    auto index = int(_entries.size()) - 1;
+
+    // The drum is kept even if its embedding can't be, it just won't turn up in searches
+    if (!embedding.empty() && writeEmbedding(index, embedding))
+        _similarity.add(index, embedding.data());
+
+    return index;
+}
+
+juce::Array<int> DrumLibrary::findSimilar(const std::vector<float>& embedding, int maxResults)
+{
+    const juce::ScopedLock sl(_lock);
+    return findSimilar(embedding, maxResults, -1);
+}
+
+juce::Array<int> DrumLibrary::findSimilar(int index, int maxResults)
+{
+    const juce::ScopedLock sl(_lock);
+
+    if (!juce::isPositiveAndBelow(index, int(_entries.size())))
+        return {};
+
+    return findSimilar(readEmbedding(index), maxResults, index);
+}
+
+Drum DrumLibrary::load(int index)
+{
+    const juce::ScopedLock sl(_lock);
+
+    if (!juce::isPositiveAndBelow(index, int(_entries.size())))
+        return {};
+
+    if (_mapping == nullptr)
+        _mapping = new Mapping(_recordsFile);
+
+    auto base = static_cast<float*>(_mapping->mapped.getData());
+
+    if (base == nullptr || _mapping->mapped.getSize() < (size_t(index) + 1) * recordSizeInBytes)
+        return {};
+
+    float* channels[] = { base + size_t(index) * size_t(recordStride) + Sample::numGuardSamples };
+    auto& entry = _entries[size_t(index)];
+    auto& analysis = _analyses[size_t(index)];
+
+    Drum d;
+    d.sample = new Sample(channels, 1, recordLength, sampleRate, _mapping.get(), analysis.hash, analysis.levels);
+    d.drumType = entry.drumType;
+    d.confidence = entry.confidence;
+
+    return d;
+}
+
+DrumLibrary::Analysis DrumLibrary::analyse(const juce::AudioBuffer<float>& data)
+{
+    // Hashed as the mono recordLength buffer a loaded Sample refers to, so both hash the same
+    Analysis a;
+    a.hash = Utils::hashBuffer(data);
+    a.levels = Sample::analyse(data);
+
+    return a;
+}
+
+void DrumLibrary::readIndex()
+{
+    _entries.clear();
+    _analyses.clear();
+
+    auto version = readIndexEntries();
+
+    // Upgraded once the index is closed, as the upgrade replaces the file
+    if (version == 1 && !upgradeIndex())
+    {
+        _entries.clear();
+        _analyses.clear();
+    }
+}
+
+int DrumLibrary::readIndexEntries()
+{
+    juce::FileInputStream stream{ _indexFile };
+
+    if (!stream.openedOk() || stream.getTotalLength() < indexHeaderSize || stream.readInt() != indexFileMagic)
+        return 0;
+
+    auto version = stream.readInt();
+
+    if ((version != 1 && version != indexFileVersion) || stream.readInt() != recordStride)
+        return 0;
+
+    // Entries without a whole record behind them are from an interrupted write
+    auto entrySize = version == 1 ? indexEntrySizeV1 : indexEntrySize;
+    auto numRecords = size_t(_recordsFile.getSize()) / recordSizeInBytes;
+    auto numEntries = juce::jmin(numRecords, size_t(stream.getNumBytesRemaining() / entrySize));
+    _entries.reserve(numEntries);
+    _analyses.reserve(numEntries);
+
+    for (size_t i = 0; i < numEntries; i++)
+    {
+        Entry e;
+        e.drumType = static_cast<DrumType>(stream.readInt());
+        e.confidence = stream.readFloat();
+        e.seed = juce::uint32(stream.readInt());
+        e.time = stream.readInt64();
+        _entries.push_back(e);
+
+        if (version == 1)
+            continue;
+
+        Analysis a;
+        a.hash = stream.readInt64();
+        a.levels.audibleLength = stream.readInt();
+        a.levels.rms.resize(size_t(numLevelBlocks));
+        a.levels.peak.resize(size_t(numLevelBlocks));
+
+        for (auto& x : a.levels.rms)
+            x = stream.readFloat();
+
+        for (auto& x : a.levels.peak)
+            x = stream.readFloat();
+
+        a.levels.updateRemainingPeak();
+        _analyses.push_back(std::move(a));
+    }
+
+    return version;
+}
+
+bool DrumLibrary::upgradeIndex()
+{
+    // Analyses every record once, so that loads from then on don't have to
+    juce::FileInputStream records{ _recordsFile };
+
+    if (!records.openedOk())
+        return false;
+
+    juce::AudioBuffer<float> data{ 1, recordLength };
+
+    for (size_t i = 0; i < _entries.size(); i++)
+    {
+        auto bytes = int(recordLength * sizeof(float));
+
+        if (!records.setPosition(juce::int64(i * recordSizeInBytes) + Sample::numGuardSamples * juce::int64(sizeof(float)))
+            || records.read(data.getWritePointer(0), bytes) != bytes)
+            return false;
+
+        _analyses.push_back(analyse(data));
+    }
+
+    // Written alongside and then swapped in, so an interrupted upgrade leaves the old index intact
+    juce::TemporaryFile temp{ _indexFile };
+
+    {
+        juce::FileOutputStream stream{ temp.getFile() };
+
+        if (!stream.openedOk() || !writeIndexHeader(stream))
+            return false;
+
+        for (size_t i = 0; i < _entries.size(); i++)
+            writeIndexEntry(stream, _entries[i], _analyses[i]);
+
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return false;
+    }
+
+    return temp.overwriteTargetFileWithTemporary();
+}
+
+juce::Array<int> DrumLibrary::findSimilar(const std::vector<float>& embedding, int maxResults, int excludedIndex)
+{
+    juce::Array<int> result;
+
+    if (embedding.empty() || int(embedding.size()) != _similarity.getDimension())
+        return result;
+
+    for (auto& match : _similarity.findNearest(embedding.data(), maxResults, excludedIndex))
+        result.add(match.id);
+
+    return result;
+}
+
+bool DrumLibrary::writeIndexHeader(juce::OutputStream& stream)
+{
+    return stream.writeInt(indexFileMagic)
+        && stream.writeInt(indexFileVersion)
+        && stream.writeInt(recordStride);
+}
+
+bool DrumLibrary::writeIndexEntry(const Entry& entry, const Analysis& analysis)
+{
+    juce::FileOutputStream stream{ _indexFile };
+
+    if (!stream.openedOk())
+        return false;
+
+    // Rewrites the header for a new or unreadable index, and drops any partial entry
+    if (_entries.empty())
+    {
+        stream.setPosition(0);
+        stream.truncate();
+        writeIndexHeader(stream);
+    }
+    else
+    {
+        stream.setPosition(indexHeaderSize + juce::int64(_entries.size()) * indexEntrySize);
+        stream.truncate();
+    }
+
+    writeIndexEntry(stream, entry, analysis);
+    stream.flush();
+
+    return !stream.getStatus().failed();
+}
+
+void DrumLibrary::writeIndexEntry(juce::OutputStream& stream, const Entry& entry, const Analysis& analysis)
+{
+    jassert(analysis.levels.rms.size() == size_t(numLevelBlocks) && analysis.levels.peak.size() == size_t(numLevelBlocks));
+
+    stream.writeInt(int(entry.drumType));
+    stream.writeFloat(entry.confidence);
+    stream.writeInt(int(entry.seed));
+    stream.writeInt64(entry.time);
+
+    stream.writeInt64(analysis.hash);
+    stream.writeInt(analysis.levels.audibleLength);
+
+    for (auto x : analysis.levels.rms)
+        stream.writeFloat(x);
+
+    for (auto x : analysis.levels.peak)
+        stream.writeFloat(x);
+}
+
+void DrumLibrary::readEmbeddings()
+{
+    _similarity.reset(0);
+
+    juce::FileInputStream stream{ _embeddingsFile };
+
+    if (!stream.openedOk() || stream.getTotalLength() < embeddingsHeaderSize)
+        return;
+
+    if (stream.readInt() != embeddingsFileMagic || stream.readInt() != embeddingsFileVersion)
+        return;
+
+    auto dimension = stream.readInt();
+
+    if (dimension <= 0)
+        return;
+
+    _similarity.reset(dimension);
+
+    auto recordSize = size_t(dimension) * sizeof(float);
+    auto numRecords = juce::jmin(_entries.size(), size_t(stream.getNumBytesRemaining()) / recordSize);
+    std::vector<float> embedding(size_t(dimension), 0.0f);
+
+    // Entries stored without an embedding have zeros, which the index leaves out
+    for (size_t i = 0; i < numRecords; i++)
+    {
+        if (stream.read(embedding.data(), int(recordSize)) != int(recordSize))
+            break;
+
+        _similarity.add(int(i), embedding.data());
+    }
+}
+
+std::vector<float> DrumLibrary::readEmbedding(int index) const
+{
+    auto dimension = _similarity.getDimension();
+    auto recordSize = size_t(dimension) * sizeof(float);
+
+    juce::FileInputStream stream{ _embeddingsFile };
+
+    if (dimension <= 0 || !stream.openedOk())
+        return {};
+
+    std::vector<float> embedding(size_t(dimension), 0.0f);
+
+    if (!stream.setPosition(embeddingsHeaderSize + juce::int64(index) * juce::int64(recordSize))
+        || stream.read(embedding.data(), int(recordSize)) != int(recordSize))
+        return {};
+
+    return embedding;
+}
+
+bool DrumLibrary::writeEmbedding(int index, const std::vector<float>& embedding)
+{
+    juce::FileOutputStream stream{ _embeddingsFile };
+
+    if (!stream.openedOk())
+        return false;
+
+    auto dimension = int(embedding.size());
+    auto recordSize = size_t(dimension) * sizeof(float);
+
+    // Starts again for a new or unreadable file, or when a different classifier has changed the
+    // embedding size, as embeddings from different models can't be compared
+    if (dimension != _similarity.getDimension())
+    {
+        _similarity.reset(dimension);
+
+        stream.setPosition(0);
+        stream.truncate();
+        stream.writeInt(embeddingsFileMagic);
+        stream.writeInt(embeddingsFileVersion);
+        stream.writeInt(dimension);
+    }
+
+    // Drops any partial record, then fills in zeros for entries stored without an embedding
+    auto numRecords = juce::jmin(juce::int64(index), (stream.getPosition() - embeddingsHeaderSize) / juce::int64(recordSize));
+    stream.setPosition(embeddingsHeaderSize + numRecords * juce::int64(recordSize));
+    stream.truncate();
+
+    const std::vector<float> zeros(size_t(dimension), 0.0f);
+
+    for (; numRecords < index; numRecords++)
+        stream.write(zeros.data(), recordSize);
+
+    stream.write(embedding.data(), recordSize);
+    stream.flush();
+
+    return !stream.getStatus().failed();
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sample.h"
+#include "SimilarityIndex.h"
+
+/**
+    Persistent library of generated drums.
+
+    Audio lives in one records file of fixed-size float records, each holding
+    recordLength samples with Sample's guard zeros on either side, so that a
+    record can be used in place as a Sample. The file is memory-mapped and
+    loading an entry refers straight into the mapping, so the library can
+    hold thousands of drums without reading them into memory. A separate index
+    file holds each entry's type, confidence, seed and date, along with the
+    hash and level envelope a Sample needs, so that loading a drum doesn't
+    read its audio. A third
+    holds each entry's classifier embedding, which is kept in a similarity
+    index so that drums like a given one can be found without generating.
+
+    Shared by every plugin instance in the process.
+*/
+class DrumLibrary
+{
+public:
+    // Matches UnetModelInference
+    static constexpr int recordLength{ 21000 };
+    static constexpr double sampleRate{ 44.1e3 };
+
+    struct Entry
+    {
+        DrumType drumType{ DrumType::none };
+        float confidence{ 0.0f };
+        juce::uint32 seed{ 0 };
+
+        // Milliseconds since the epoch
+        juce::int64 time{ 0 };
+    };
+
+    // Uses the library in the user's application data folder
+    DrumLibrary();
+    explicit DrumLibrary(const juce::File& directory);
+    ~DrumLibrary() = default;
+
+    int getNumEntries() const;
+    Entry getEntry(int index) const;
+
+    // Indices of every entry of one type, newest first
+    juce::Array<int> findEntries(DrumType drumType) const;
+
+    // Index of the newest entry whose audio has the given Sample hash, or -1 if there is none
+    int findEntry(juce::int64 hash) const;
+
+    // Appends a mono recordLength drum, returning its index, or -1 if it couldn't be written.
+    // Drums stored without an embedding aren't found by findSimilar.
+    int add(const juce::AudioBuffer<float>& data, const Entry& entry, const std::vector<float>& embedding = {});
+
+    // Indices of the entries with the closest embeddings, most similar first
+    juce::Array<int> findSimilar(const std::vector<float>& embedding, int maxResults);
+    juce::Array<int> findSimilar(int index, int maxResults);
+
+    // The drum refers into the library file rather than holding a copy
+    Drum load(int index);
+
+private:
+    struct Mapping : public juce::ReferenceCountedObject
+    {
+        Mapping(const juce::File& file) : mapped(file, juce::MemoryMappedFile::readOnly) {}
+
+        juce::MemoryMappedFile mapped;
+    };
+
+    static constexpr int recordStride{ recordLength + 2 * Sample::numGuardSamples };
+    static constexpr size_t recordSizeInBytes{ size_t(recordStride) * sizeof(float) };
+
+    // Worked out from the audio when it is added, and kept in the index
+    struct Analysis
+    {
+        juce::int64 hash{ 0 };
+        Sample::Levels levels;
+    };
+
+    static Analysis analyse(const juce::AudioBuffer<float>& data);
+
+    void readIndex();
+
+    // Returns the version read, or 0 if there was no readable index
+    int readIndexEntries();
+
+    // Adds the analyses a version 1 index lacked, and rewrites it at the current version
+    bool upgradeIndex();
+
+    static bool writeIndexHeader(juce::OutputStream& stream);
+    bool writeIndexEntry(const Entry& entry, const Analysis& analysis);
+    static void writeIndexEntry(juce::OutputStream& stream, const Entry& entry, const Analysis& analysis);
+
+    void readEmbeddings();
+    std::vector<float> readEmbedding(int index) const;
+    bool writeEmbedding(int index, const std::vector<float>& embedding);
+    juce::Array<int> findSimilar(const std::vector<float>& embedding, int maxResults, int excludedIndex);
+
+    juce::File _recordsFile;
+    juce::File _indexFile;
+    juce::File _embeddingsFile;
+
+    mutable juce::CriticalSection _lock;
+    std::vector<Entry> _entries;
+    std::vector<Analysis> _analyses;
+
+    // Embeddings from the current classifier, those from another one aren't comparable
+    SimilarityIndex _similarity;
+
+    // Remade after adds, while drums loaded earlier keep the mapping they refer to
+    juce::ReferenceCountedObjectPtr<Mapping> _mapping;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DrumLibrary)
+};
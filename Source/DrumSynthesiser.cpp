@@ -0,0 +1,298 @@
+#include "DrumSynthesiser.h"
+
+void DrumSynthesiser::addDrumSound(Sound* sound)
+{
+    auto note = sound->getMidiNote();
+    jassert(juce::isPositiveAndBelow(note, numMidiNotes));
+
+    _sounds.add(sound);
+    _noteToSound[size_t(note)] = sound;
+    _soundNotes.addIfNotAlreadyThere(note);
+    _slotsByNote[size_t(note)].ensureStorageAllocated(_voices.size());
+}
+
+void DrumSynthesiser::addDrumVoice(Voice* voice)
+{
+    _freeSlots.add(_slots.size());
+    _slots.add({ voice, -1, 0 });
+    _voices.add(voice);
+
+    // Reserve up front so that note handling never allocates on the audio thread
+    auto numVoices = _voices.size();
+    _freeSlots.ensureStorageAllocated(numVoices);
+    _activeSlots.ensureStorageAllocated(numVoices);
+    _laneVoices.ensureStorageAllocated(numVoices);
+    _lanes.prepare(numVoices);
+
+    for (size_t note = 0; note < numMidiNotes; note++)
+        if (_noteToSound[note] != nullptr)
+            _slotsByNote[note].ensureStorageAllocated(numVoices);
+}
+
+Sound* DrumSynthesiser::getSoundForNote(int midiNoteNumber) const
+{
+    return juce::isPositiveAndBelow(midiNoteNumber, numMidiNotes) ? _noteToSound[size_t(midiNoteNumber)] : nullptr;
+}
+
+void DrumSynthesiser::setMaxVoicesPerPad(int maxVoices)
+{
+    jassert(maxVoices > 0);
+    _maxVoicesPerPad = juce::jmax(1, maxVoices);
+}
+
+int DrumSynthesiser::getMaxVoicesPerPad() const
+{
+    return _maxVoicesPerPad;
+}
+
+void DrumSynthesiser::setChokeGroup(int midiNoteNumber, int group)
+{
+    jassert(juce::isPositiveAndBelow(midiNoteNumber, numMidiNotes));
+    jassert(juce::isPositiveAndNotGreaterThan(group, maxNumChokeGroups));
+
+    if (juce::isPositiveAndBelow(midiNoteNumber, numMidiNotes))
+        _chokeGroups[size_t(midiNoteNumber)] = juce::jlimit(0, maxNumChokeGroups, group);
+}
+
+int DrumSynthesiser::getChokeGroup(int midiNoteNumber) const
+{
+    return juce::isPositiveAndBelow(midiNoteNumber, numMidiNotes) ? _chokeGroups[size_t(midiNoteNumber)].load() : 0;
+}
+
+void DrumSynthesiser::renderNextBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midi, int startSample, int numSamples)
+{
+    jassert(buffer.getNumChannels() == 2);
+
+    _outL = buffer.getWritePointer(0, startSample);
+    _outR = buffer.getWritePointer(1, startSample);
+
+    for (auto i : _activeSlots)
+        _slots.getReference(i).renderedUntil = 0;
+
+    if (auto pending = _pendingNotesOff.exchange(kNone); pending != kNone)
+        stopAllVoices(pending == kTailOff, 0);
+
+    // Events are applied in order at their own offsets, with no sub-blocks in between
+    auto endSample = startSample + numSamples;
+
+    for (auto it = midi.findNextSamplePosition(startSample); it != midi.cend(); ++it)
+    {
+        const auto metadata = *it;
+
+        if (metadata.samplePosition >= endSample)
+            break;
+
+        handleMidiEvent(metadata.getMessage(), metadata.samplePosition - startSample);
+    }
+
+    _laneVoices.clearQuick();
+
+    for (auto i : _activeSlots)
+    {
+        auto& s = _slots.getReference(i);
+
+        if (s.renderedUntil == 0)
+            _laneVoices.add(s.voice);
+        else
+            renderUpTo(i, numSamples);
+    }
+
+    _lanes.render(_laneVoices.getRawDataPointer(), _laneVoices.size(), _outL, _outR, numSamples);
+
+    reclaimFinishedVoices();
+
+    _outL = nullptr;
+    _outR = nullptr;
+}
+
+void DrumSynthesiser::allNotesOff(bool allowTailOff)
+{
+    // A hard stop wins over a tail-off requested in the same block
+    auto request = allowTailOff ? kTailOff : kHardOff;
+    auto pending = _pendingNotesOff.load();
+
+    while (pending < request && !_pendingNotesOff.compare_exchange_weak(pending, request)) {}
+}
+
+void DrumSynthesiser::handleMidiEvent(const juce::MidiMessage& message, int offset)
+{
+    if (message.isNoteOn())
+        noteOn(message.getNoteNumber(), offset);
+    else if (message.isNoteOff())
+        noteOff(message.getNoteNumber(), offset);
+    else if (message.isAllNotesOff())
+        stopAllVoices(true, offset);
+    else if (message.isAllSoundOff())
+        stopAllVoices(false, offset);
+}
+
+void DrumSynthesiser::noteOn(int midiNoteNumber, int offset)
+{
+    auto sound = getSoundForNote(midiNoteNumber);
+
+    if (sound == nullptr)
+        return;
+
+    // Cut off the other pads in this note's choke group
+    if (auto group = _chokeGroups[size_t(midiNoteNumber)].load(); group > 0)
+    {
+        for (auto note : _soundNotes)
+        {
+            if (note == midiNoteNumber || _chokeGroups[size_t(note)].load() != group)
+                continue;
+
+            for (auto i : _slotsByNote[size_t(note)])
+            {
+                renderUpTo(i, offset);
+                _slots.getReference(i).voice->stopNote(false);
+            }
+        }
+    }
+
+    // If hitting a note that's still held, release it first
+    for (auto i : _slotsByNote[size_t(midiNoteNumber)])
+    {
+        auto voice = _slots.getReference(i).voice;
+
+        if (voice->isNoteOn())
+        {
+            renderUpTo(i, offset);
+            voice->stopNote(true);
+        }
+    }
+
+    auto slot = allocateVoice(midiNoteNumber, offset);
+
+    if (slot < 0)
+        return;
+
+    // A stolen voice fades its previous note out over its tail
+    _slots.getReference(slot).voice->startNote(*sound, midiNoteNumber);
+}
+
+void DrumSynthesiser::noteOff(int midiNoteNumber, int offset)
+{
+    if (!juce::isPositiveAndBelow(midiNoteNumber, numMidiNotes))
+        return;
+
+    for (auto i : _slotsByNote[size_t(midiNoteNumber)])
+    {
+        auto voice = _slots.getReference(i).voice;
+
+        if (voice->isNoteOn())
+        {
+            renderUpTo(i, offset);
+            voice->stopNote(true);
+        }
+    }
+}
+
+void DrumSynthesiser::stopAllVoices(bool allowTailOff, int offset)
+{
+    for (auto i : _activeSlots)
+    {
+        renderUpTo(i, offset);
+        _slots.getReference(i).voice->stopNote(allowTailOff);
+    }
+}
+
+int DrumSynthesiser::allocateVoice(int midiNoteNumber, int offset)
+{
+    auto& padSlots = _slotsByNote[size_t(midiNoteNumber)];
+
+    int numPlaying = 0;
+    for (auto i : padSlots)
+        if (_slots.getReference(i).voice->isPlayingNote())
+            numPlaying++;
+
+    int slot = -1;
+
+    if (numPlaying >= _maxVoicesPerPad)
+    {
+        slot = findQuietestVoice(padSlots, true);
+    }
+    else if (!_freeSlots.isEmpty())
+    {
+        slot = _freeSlots.removeAndReturn(_freeSlots.size() - 1);
+        _slots.getReference(slot).renderedUntil = offset;
+        _activeSlots.add(slot);
+    }
+    else
+    {
+        slot = findQuietestVoice(_activeSlots, false);
+    }
+
+    if (slot >= 0)
+    {
+        renderUpTo(slot, offset);
+        assignToNote(slot, midiNoteNumber);
+    }
+
+    return slot;
+}
+
+int DrumSynthesiser::findQuietestVoice(const juce::Array<int>& slots, bool playingOnly) const
+{
+    int quietest = -1;
+    auto lowestLevel = std::numeric_limits<float>::max();
+
+    for (auto i : slots)
+    {
+        auto voice = _slots.getReference(i).voice;
+
+        if (playingOnly && !voice->isPlayingNote())
+            continue;
+
+        auto level = voice->getLevel();
+
+        if (level < lowestLevel)
+        {
+            lowestLevel = level;
+            quietest = i;
+        }
+    }
+
+    return quietest;
+}
+
+void DrumSynthesiser::assignToNote(int slot, int midiNoteNumber)
+{
+    auto& s = _slots.getReference(slot);
+
+    if (s.midiNote == midiNoteNumber)
+        return;
+
+    if (s.midiNote >= 0)
+        _slotsByNote[size_t(s.midiNote)].removeFirstMatchingValue(slot);
+
+    s.midiNote = midiNoteNumber;
+    _slotsByNote[size_t(midiNoteNumber)].add(slot);
+}
+
+void DrumSynthesiser::renderUpTo(int slot, int offset)
+{
+    auto& s = _slots.getReference(slot);
+
+    if (offset > s.renderedUntil)
+    {
+        s.voice->render(_outL + s.renderedUntil, _outR + s.renderedUntil, offset - s.renderedUntil);
+        s.renderedUntil = offset;
+    }
+}
+
+void DrumSynthesiser::reclaimFinishedVoices()
+{
+    for (int j = _activeSlots.size(); --j >= 0;)
+    {
+        auto i = _activeSlots.getUnchecked(j);
+        auto& s = _slots.getReference(i);
+
+        if (!s.voice->isActive())
+        {
+            _activeSlots.remove(j);
+            _slotsByNote[size_t(s.midiNote)].removeFirstMatchingValue(i);
+            s.midiNote = -1;
+            _freeSlots.add(i);
+        }
+    }
+}
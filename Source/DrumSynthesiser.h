@@ -0,0 +1,112 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sampler.h"
+#include "VoiceLanes.h"
+
+/**
+    Voice manager for drum kits.
+
+    Sounds are looked up in a note-to-sound table and voices come from a free
+    list. MIDI events are applied at their exact sample offset without
+    splitting the block: each voice is only rendered up to an event's offset
+    when that event is about to change it, and every active voice is rendered
+    to the end of the block afterwards. Voices that no event has touched
+    render that whole block together through VoiceLanes.
+
+    Each pad can play a limited number of overlapping hits, beyond which its
+    quietest hit is stolen. When every voice is busy the quietest voice of any
+    pad is stolen instead. Pads in the same choke group cut each other off,
+    like an open hi-hat closed by the pedal.
+
+    The audio thread never waits on a lock. Sounds and voices are added before
+    rendering starts, and settings changed while it runs are atomics that the
+    audio thread picks up at its next note on or block.
+*/
+class DrumSynthesiser
+{
+public:
+    static constexpr int numMidiNotes{ 128 };
+    static constexpr int maxNumChokeGroups{ 16 };
+    static constexpr int defaultMaxVoicesPerPad{ 4 };
+
+    DrumSynthesiser() = default;
+    ~DrumSynthesiser() = default;
+
+    // Takes ownership. Each sound is mapped to its own MIDI note, replacing any sound already on that note.
+    // Only before rendering starts.
+    void addDrumSound(Sound* sound);
+
+    // Takes ownership. Only before rendering starts.
+    void addDrumVoice(Voice* voice);
+
+    Sound* getSoundForNote(int midiNoteNumber) const;
+
+    void setMaxVoicesPerPad(int maxVoices);
+    int getMaxVoicesPerPad() const;
+
+    // Group 0 means the note is in no choke group. Any thread, taking effect at the next note on.
+    void setChokeGroup(int midiNoteNumber, int group);
+    int getChokeGroup(int midiNoteNumber) const;
+
+    void renderNextBlock(juce::AudioBuffer<float>& buffer, const juce::MidiBuffer& midi, int startSample, int numSamples);
+
+    // Any thread, carried out at the start of the next block
+    void allNotesOff(bool allowTailOff);
+
+private:
+    struct Slot
+    {
+        Voice* voice;
+        int midiNote;
+
+        // Offset within the current block that the voice has been rendered up to
+        int renderedUntil;
+    };
+
+    void handleMidiEvent(const juce::MidiMessage& message, int offset);
+    void noteOn(int midiNoteNumber, int offset);
+    void noteOff(int midiNoteNumber, int offset);
+    void stopAllVoices(bool allowTailOff, int offset);
+
+    int allocateVoice(int midiNoteNumber, int offset);
+    // Voices that only have a tail left are silent and so are taken first, unless playingOnly
+    int findQuietestVoice(const juce::Array<int>& slots, bool playingOnly) const;
+    void assignToNote(int slot, int midiNoteNumber);
+
+    // Brings a voice's output up to offset within the current block, before an event changes it
+    void renderUpTo(int slot, int offset);
+    void reclaimFinishedVoices();
+
+    juce::OwnedArray<Sound> _sounds;
+    juce::OwnedArray<Voice> _voices;
+
+    std::array<Sound*, numMidiNotes> _noteToSound{};
+
+    // Notes that have a sound, which are the only ones a choke can reach
+    juce::Array<int> _soundNotes;
+
+    std::array<std::atomic<int>, numMidiNotes> _chokeGroups{};
+    std::atomic<int> _maxVoicesPerPad{ defaultMaxVoicesPerPad };
+
+    // No request, or all notes off with or without tail-off
+    enum PendingNotesOff { kNone = 0, kTailOff, kHardOff };
+    std::atomic<int> _pendingNotesOff{ kNone };
+
+    // Indexed the same as _voices
+    juce::Array<Slot> _slots;
+    juce::Array<int> _freeSlots;
+    juce::Array<int> _activeSlots;
+
+    // Voices started on each note that haven't been reclaimed yet
+    std::array<juce::Array<int>, numMidiNotes> _slotsByNote;
+
+    VoiceLanes _lanes;
+    juce::Array<Voice*> _laneVoices;
+
+    // Output of the block being rendered
+    float* _outL{ nullptr };
+    float* _outR{ nullptr };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DrumSynthesiser)
+};
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Linear ADSR with the same segment behaviour as juce::ADSR, that can also
+    render its output a block at a time.
+
+    Every segment is a straight line, so render() writes each one as a single
+    ramp instead of stepping the state machine once per sample.
+*/
+class Envelope
+{
+public:
+    Envelope() = default;
+    ~Envelope() = default;
+
+    void setSampleRate(double sampleRate)
+    {
+        jassert(sampleRate > 0.0);
+        _sampleRate = sampleRate;
+        recalculateRates();
+    }
+
+    void setParameters(const juce::ADSR::Parameters& params)
+    {
+        _parameters = params;
+        recalculateRates();
+    }
+
+    void noteOn()
+    {
+        if (_attackRate > 0.0f)
+        {
+            _state = State::attack;
+        }
+        else if (_decayRate > 0.0f)
+        {
+            _level = 1.0f;
+            _state = State::decay;
+        }
+        else
+        {
+            _level = _parameters.sustain;
+            _state = State::sustain;
+        }
+    }
+
+    void noteOff()
+    {
+        if (_state == State::idle)
+            return;
+
+        if (_parameters.release > 0.0f && _level > 0.0f)
+        {
+            // Releases from wherever the envelope currently is
+            _releaseRate = float(_level / (_parameters.release * _sampleRate));
+            _state = State::release;
+        }
+        else
+        {
+            reset();
+        }
+    }
+
+    void reset()
+    {
+        _level = 0.0f;
+        _state = State::idle;
+    }
+
+    bool isActive() const
+    {
+        return _state != State::idle;
+    }
+
+    float getLevel() const
+    {
+        return _level;
+    }
+
+    // Highest level still to come before the next note on
+    float getPeakLevel() const
+    {
+        switch (_state)
+        {
+            case State::attack:  return 1.0f;
+            case State::decay:   return _level;
+            case State::sustain: return _parameters.sustain;
+            case State::release: return _level;
+            case State::idle:    break;
+        }
+
+        return 0.0f;
+    }
+
+    // The straight line the envelope is currently on: it moves by rate each sample and
+    // lands exactly on target after numSamples samples, or never leaves it when rate is 0
+    struct Segment
+    {
+        float rate;
+        float target;
+        int numSamples;
+    };
+
+    Segment getSegment() const
+    {
+        switch (_state)
+        {
+            case State::attack:  return { _attackRate, 1.0f, getNumStepsTo(1.0f, _attackRate) };
+            case State::decay:   return { -_decayRate, _parameters.sustain, getNumStepsTo(_parameters.sustain, -_decayRate) };
+            case State::release: return { -_releaseRate, 0.0f, getNumStepsTo(0.0f, -_releaseRate) };
+            case State::sustain: return { 0.0f, _parameters.sustain, std::numeric_limits<int>::max() };
+            case State::idle:    break;
+        }
+
+        return { 0.0f, 0.0f, std::numeric_limits<int>::max() };
+    }
+
+    // Moves on by numSamples as render() would, without writing anything
+    void advance(int numSamples)
+    {
+        while (numSamples > 0 && _state != State::idle)
+        {
+            if (_state == State::sustain)
+            {
+                _level = _parameters.sustain;
+                return;
+            }
+
+            auto segment = getSegment();
+            auto n = juce::jmin(numSamples, segment.numSamples);
+
+            if (n == segment.numSamples)
+            {
+                _level = segment.target;
+                _state = getNextState();
+
+                if (_state == State::idle)
+                    reset();
+            }
+            else
+            {
+                _level += float(n) * segment.rate;
+            }
+
+            numSamples -= n;
+        }
+    }
+
+    // Writes up to numSamples values to dest, returning fewer if the envelope finishes first
+    int render(float* dest, int numSamples)
+    {
+        int i = 0;
+
+        while (i < numSamples && _state != State::idle)
+        {
+            auto numLeft = numSamples - i;
+
+            switch (_state)
+            {
+                case State::attack:
+                    i += ramp(dest + i, numLeft, _attackRate, 1.0f, getNextState());
+                    break;
+
+                case State::decay:
+                    i += ramp(dest + i, numLeft, -_decayRate, _parameters.sustain, getNextState());
+                    break;
+
+                case State::sustain:
+                    _level = _parameters.sustain;
+                    std::fill_n(dest + i, numLeft, _level);
+                    i = numSamples;
+                    break;
+
+                case State::release:
+                    i += ramp(dest + i, numLeft, -_releaseRate, 0.0f, getNextState());
+                    break;
+
+                case State::idle:
+                    break;
+            }
+        }
+
+        return i;
+    }
+
+private:
+    enum class State
+    {
+        idle,
+        attack,
+        decay,
+        sustain,
+        release
+    };
+
+    State getNextState() const
+    {
+        switch (_state)
+        {
+            case State::attack:  return _decayRate > 0.0f ? State::decay : State::sustain;
+            case State::decay:   return State::sustain;
+            case State::release: return State::idle;
+            case State::sustain: return State::sustain;
+            case State::idle:    break;
+        }
+
+        return State::idle;
+    }
+
+    // Number of steps until the target is reached or passed, the last of which lands exactly on it
+    int getNumStepsTo(float target, float rate) const
+    {
+        jassert(rate != 0.0f);
+        return juce::jmax(1, int(std::ceil((target - _level) / rate)));
+    }
+
+    // Steps the level by rate until it reaches target, then moves on to next
+    int ramp(float* dest, int numSamples, float rate, float target, State next)
+    {
+        auto numToTarget = getNumStepsTo(target, rate);
+        auto n = juce::jmin(numSamples, numToTarget);
+
+        for (int k = 0; k < n; k++)
+            dest[k] = _level + float(k + 1) * rate;
+
+        if (n == numToTarget)
+        {
+            dest[n - 1] = target;
+            _level = target;
+            _state = next;
+
+            if (next == State::idle)
+                reset();
+        }
+        else
+        {
+            _level = dest[n - 1];
+        }
+
+        return n;
+    }
+
+    void recalculateRates()
+    {
+        auto getRate = [this](float distance, float timeInSeconds)
+        {
+            return timeInSeconds > 0.0f ? float(distance / (timeInSeconds * _sampleRate)) : -1.0f;
+        };
+
+        _attackRate = getRate(1.0f, _parameters.attack);
+        _decayRate = getRate(1.0f - _parameters.sustain, _parameters.decay);
+        _releaseRate = getRate(_parameters.sustain, _parameters.release);
+    }
+
+    juce::ADSR::Parameters _parameters;
+    double _sampleRate{ 44100.0 };
+
+    State _state{ State::idle };
+    float _level{ 0.0f };
+    float _attackRate{ 0.0f }, _decayRate{ 0.0f }, _releaseRate{ 0.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Envelope)
+};
@@ -0,0 +1,100 @@
+#include "FolderClassifier.h"
+#include "UnetModelInference.h"
+
+FolderClassifier::FolderClassifier(AudioFileLoader& loader, ClassifierModelInference& classifier)
+    : _loader(loader),
+      _classifier(classifier)
+{
+}
+
+std::vector<FolderClassifier::Result> FolderClassifier::classify(const juce::Array<juce::File>& files)
+{
+    std::vector<Result> results;
+
+    if (files.isEmpty())
+        return results;
+
+    // One batch decodes while the other is classified
+    Batch batches[2];
+    int current = 0;
+
+    decode(files, 0, batches[current]);
+
+    for (int start = 0; start < files.size(); start += batchSize)
+    {
+        if (start + batchSize < files.size())
+            decode(files, start + batchSize, batches[1 - current]);
+
+        classify(files, batches[current], results);
+        current = 1 - current;
+    }
+
+    return results;
+}
+
+void FolderClassifier::decode(const juce::Array<juce::File>& files, int start, Batch& batch)
+{
+    constexpr int length = ClassifierModelInference::inputSize;
+
+    batch.start = start;
+    batch.size = juce::jmin(batchSize, files.size() - start);
+    batch.audio.assign(size_t(batch.size) * length, 0.0f);
+    batch.isValid.assign(size_t(batch.size), 0);
+    batch.numPending = batch.size;
+    batch.done.reset();
+
+    for (int i = 0; i < batch.size; i++)
+    {
+        _pool.addJob([this, &batch, file = files[start + i], i]
+        {
+            AudioFileLoader::Options options;
+            options.numSamples = length;
+            options.sampleRate = UnetModelInference::sampleRate;
+            options.startAtOnset = true;
+            options.mono = true;
+
+            auto audio = _loader.load(file, options);
+
+            if (audio.getNumSamples() == length)
+            {
+                // Normalised like the drums the classifier sees elsewhere, with silence left out
+                auto range = juce::FloatVectorOperations::findMinAndMax(audio.getReadPointer(0), length);
+                auto peak = juce::jmax(std::abs(range.getStart()), std::abs(range.getEnd()));
+
+                if (peak > 0.0f)
+                {
+                    juce::FloatVectorOperations::multiply(batch.audio.data() + size_t(i) * length, audio.getReadPointer(0), 1.0f / peak, length);
+                    batch.isValid[size_t(i)] = 1;
+                }
+            }
+
+            if (--batch.numPending == 0)
+                batch.done.signal();
+        });
+    }
+}
+
+void FolderClassifier::classify(const juce::Array<juce::File>& files, Batch& batch, std::vector<Result>& results)
+{
+    batch.done.wait();
+
+    auto size = size_t(batch.size);
+    std::vector<size_t> classifications(size);
+    std::vector<float> confidences(size);
+
+    // Unreadable files are left in as silence rather than repacking the batch
+    _classifier.processBatch(batch.audio.data(), size, classifications.data(), confidences.data());
+
+    for (size_t i = 0; i < size; i++)
+    {
+        if (!batch.isValid[i])
+            continue;
+
+        // 0 = Kick, 1 = Hat, 2 = Snare
+        Result r;
+        r.file = files[batch.start + int(i)];
+        r.drumType = static_cast<DrumType>(classifications[i] + 1);
+        r.confidence = confidences[i];
+        results.push_back(r);
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "AudioFileLoader.h"
+#include "ClassifierModelInference.h"
+#include "Sample.h"
+
+/**
+    Classifies many audio files as kick, snare or hat.
+
+    Files are decoded in batches on a pool with a thread per core, each read as
+    the classifier's window from its first onset, and every batch goes through
+    the classifier in one call. The next batch decodes while the current one is
+    being classified, so the classifier is rarely kept waiting.
+*/
+class FolderClassifier
+{
+public:
+    static constexpr int batchSize{ 32 };
+
+    struct Result
+    {
+        juce::File file;
+        DrumType drumType{ DrumType::none };
+        float confidence{ 0.0f };
+    };
+
+    FolderClassifier(AudioFileLoader& loader, ClassifierModelInference& classifier);
+    ~FolderClassifier() = default;
+
+    // In the order of files, leaving out any that can't be read or are silent
+    std::vector<Result> classify(const juce::Array<juce::File>& files);
+
+private:
+    struct Batch
+    {
+        int start{ 0 };
+        int size{ 0 };
+        std::vector<float> audio;
+        std::vector<char> isValid;
+
+        std::atomic<int> numPending{ 0 };
+        juce::WaitableEvent done;
+    };
+
+    void decode(const juce::Array<juce::File>& files, int start, Batch& batch);
+    void classify(const juce::Array<juce::File>& files, Batch& batch, std::vector<Result>& results);
+
+    AudioFileLoader& _loader;
+    ClassifierModelInference& _classifier;
+
+    juce::ThreadPool _pool{ juce::SystemStats::getNumCpus() };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FolderClassifier)
+};
@@ -0,0 +1,77 @@
+#include "Interpolator.h"
+
+namespace
+{
+    // Kaiser window shape, about 90 dB of stop-band attenuation
+    constexpr double kaiserBeta = 8.6;
+
+    // Tables stop at a little below the shifted Nyquist to leave room for the transition band
+    constexpr double cutoffMargin = 0.8;
+
+    double besselI0(double x)
+    {
+        double sum = 1.0, term = 1.0;
+
+        for (int k = 1; k < 32; k++)
+        {
+            auto t = x / (2.0 * k);
+            term *= t * t;
+            sum += term;
+
+            if (term < sum * 1e-12)
+                break;
+        }
+
+        return sum;
+    }
+}
+
+SincTable::SincTable(double cutoff)
+    : _coefficients(size_t((numPhases + 1) * numTaps))
+{
+    jassert(cutoff > 0.0 && cutoff <= 1.0);
+
+    constexpr auto halfLength = double(numTaps / 2);
+    const auto windowNorm = 1.0 / besselI0(kaiserBeta);
+
+    for (int p = 0; p <= numPhases; p++)
+    {
+        auto frac = double(p) / double(numPhases);
+        auto c = _coefficients.get() + p * numTaps;
+        double sum = 0.0;
+        double taps[numTaps];
+
+        for (int k = 0; k < numTaps; k++)
+        {
+            // Distance of tap k from the interpolated position
+            auto t = double(k - numTaps / 2 + 1) - frac;
+            auto w = 1.0 - (t * t) / (halfLength * halfLength);
+            auto window = w > 0.0 ? besselI0(kaiserBeta * std::sqrt(w)) * windowNorm : 0.0;
+            auto x = juce::MathConstants<double>::pi * cutoff * t;
+            auto sinc = std::abs(x) < 1e-9 ? 1.0 : std::sin(x) / x;
+
+            taps[k] = cutoff * sinc * window;
+            sum += taps[k];
+        }
+
+        // Unity gain at DC for every phase
+        for (int k = 0; k < numTaps; k++)
+            c[k] = float(taps[k] / sum);
+    }
+}
+
+SincTableSet::SincTableSet()
+{
+    // Downward shifts and unshifted playback keep the source band, less the same transition margin,
+    // so that images above the source Nyquist are rejected too. Whole-sample reads skip the table.
+    _tables.add(new SincTable(cutoffMargin));
+
+    for (int i = 1; i <= maxSemitones; i++)
+        _tables.add(new SincTable(cutoffMargin / std::pow(2.0, i / 12.0)));
+}
+
+const SincTable& SincTableSet::getTable(double pitchSemitones) const
+{
+    auto index = juce::jlimit(0, maxSemitones, int(std::ceil(pitchSemitones)));
+    return *_tables.getUnchecked(index);
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sample.h"
+
+enum class InterpolationQuality
+{
+    linear = 0,
+    hermite,    // 4-point, 3rd-order
+    sinc        // 32-point polyphase windowed sinc
+};
+
+/**
+    Polyphase Kaiser-windowed sinc table for one cutoff frequency.
+
+    Each phase holds numTaps coefficients applied to data[index - numTaps / 2 + 1]
+    onwards. Adjacent phases are linearly interpolated, so the table has one
+    extra phase at the end.
+*/
+class SincTable
+{
+public:
+    // A multiple of the kernel's lane count
+    static constexpr int numTaps{ 32 };
+    static constexpr int numPhases{ 256 };
+
+    // Cutoff is relative to Nyquist
+    explicit SincTable(double cutoff);
+    ~SincTable() = default;
+
+    const float* getPhase(int phase) const { return _coefficients.get() + phase * numTaps; }
+
+private:
+    juce::HeapBlock<float> _coefficients;
+
+    JUCE_DECLARE_NON_COPYABLE(SincTable)
+};
+
+/**
+    One sinc table per semitone of upward pitch shift, with the cutoff lowered
+    to the shifted Nyquist so that pitching up does not alias, and one for no
+    shift or a downward one, which cuts off just below the source Nyquist so
+    that pitching down does not image. Every table is
+    built up front and never changes, so voices can read them from the audio
+    thread.
+*/
+class SincTableSet
+{
+public:
+    static constexpr int maxSemitones{ 24 };
+
+    SincTableSet();
+    ~SincTableSet() = default;
+
+    // Fractional shifts use the next semitone up, downward shifts use the unshifted table
+    const SincTable& getTable(double pitchSemitones) const;
+
+private:
+    juce::OwnedArray<SincTable> _tables;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SincTableSet)
+};
+
+/**
+    Reads fractional positions from sample data.
+
+    Data must come from a Sample, whose guard samples make every read within
+    [0, numSamples) safe for all kernels.
+*/
+struct Interpolator
+{
+    static_assert(SincTable::numTaps / 2 <= Sample::numGuardSamples, "Sample guard is too short for the sinc kernel");
+
+    static float linear(const float* data, int index, float frac)
+    {
+        auto x0 = data[index];
+        auto x1 = data[index + 1];
+
+        return x0 + frac * (x1 - x0);
+    }
+
+    static float hermite(const float* data, int index, float frac)
+    {
+        auto xm1 = data[index - 1];
+        auto x0 = data[index];
+        auto x1 = data[index + 1];
+        auto x2 = data[index + 2];
+
+        auto c1 = 0.5f * (x1 - xm1);
+        auto c2 = xm1 - 2.5f * x0 + 2.0f * x1 - 0.5f * x2;
+        auto c3 = 0.5f * (x2 - xm1) + 1.5f * (x0 - x1);
+
+        return ((c3 * frac + c2) * frac + c1) * frac + x0;
+    }
+
+    static float sinc(const SincTable& table, const float* data, int index, float frac)
+    {
+        // Rounding can push frac to exactly 1, which must still land on a valid phase pair
+        auto position = frac * float(SincTable::numPhases);
+        auto phase = juce::jmin(int(position), SincTable::numPhases - 1);
+        auto g = position - float(phase);
+
+        auto c0 = table.getPhase(phase);
+        auto c1 = table.getPhase(phase + 1);
+        auto x = data + index - SincTable::numTaps / 2 + 1;
+
+        // Blends the two phases per tap and keeps independent partial sums per lane,
+        // so the compiler can vectorise without reassociating a single sum
+        constexpr int numLanes = 8;
+        float acc[numLanes] = {};
+
+        for (int k = 0; k < SincTable::numTaps; k += numLanes)
+            for (int l = 0; l < numLanes; l++)
+                acc[l] += (c0[k + l] + g * (c1[k + l] - c0[k + l])) * x[k + l];
+
+        float sum = 0.0f;
+        for (int l = 0; l < numLanes; l++)
+            sum += acc[l];
+
+        return sum;
+    }
+
+    static float read(InterpolationQuality quality, const SincTable& table, const float* data, double position)
+    {
+        auto index = int(position);
+        auto frac = float(position - double(index));
+
+        switch (quality)
+        {
+            case InterpolationQuality::linear:  return linear(data, index, frac);
+            case InterpolationQuality::hermite: return hermite(data, index, frac);
+            case InterpolationQuality::sinc:    return sinc(table, data, index, frac);
+        }
+
+        return linear(data, index, frac);
+    }
+
+    // Renders numSamples samples starting at position, advancing by increment, and returns the next position
+    template <InterpolationQuality quality>
+    static double process(const SincTable& table, const float* data, double position, double increment, float* dest, int numSamples)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            auto index = int(position);
+            auto frac = float(position - double(index));
+
+            if constexpr (quality == InterpolationQuality::linear)
+                dest[i] = linear(data, index, frac);
+            else if constexpr (quality == InterpolationQuality::hermite)
+                dest[i] = hermite(data, index, frac);
+            else
+                dest[i] = sinc(table, data, index, frac);
+
+            position += increment;
+        }
+
+        return position;
+    }
+
+    static double process(InterpolationQuality quality, const SincTable& table, const float* data, double position, double increment, float* dest, int numSamples)
+    {
+        switch (quality)
+        {
+            case InterpolationQuality::linear:  return process<InterpolationQuality::linear>(table, data, position, increment, dest, numSamples);
+            case InterpolationQuality::hermite: return process<InterpolationQuality::hermite>(table, data, position, increment, dest, numSamples);
+            case InterpolationQuality::sinc:    return process<InterpolationQuality::sinc>(table, data, position, increment, dest, numSamples);
+        }
+
+        return position;
+    }
+};
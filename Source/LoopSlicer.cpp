@@ -0,0 +1,110 @@
+#include "LoopSlicer.h"
+
+std::vector<LoopSlicer::Onset> LoopSlicer::findOnsets(const float* data, int numSamples, double sampleRate)
+{
+    auto flux = getSpectralFlux(data, numSamples);
+    auto numFrames = int(flux.size());
+
+    std::vector<Onset> onsets;
+
+    if (numFrames == 0)
+        return onsets;
+
+    auto maxFlux = *std::max_element(flux.begin(), flux.end());
+    auto minGap = juce::jmax(1, int(minOnsetGap * sampleRate / hopSize));
+    auto lastOnset = -minGap;
+
+    for (int f = 0; f < numFrames; f++)
+    {
+        auto isPeak = flux[size_t(f)] > 0.0f;
+
+        for (int k = juce::jmax(0, f - peakRadius); isPeak && k <= juce::jmin(numFrames - 1, f + peakRadius); k++)
+            isPeak = k == f || flux[size_t(k)] < flux[size_t(f)] || (k > f && flux[size_t(k)] == flux[size_t(f)]);
+
+        if (!isPeak || f - lastOnset < minGap)
+            continue;
+
+        auto first = juce::jmax(0, f - meanRadius);
+        auto last = juce::jmin(numFrames, f + meanRadius + 1);
+        auto mean = std::accumulate(flux.begin() + first, flux.begin() + last, 0.0f) / float(last - first);
+
+        if (flux[size_t(f)] < mean + thresholdOffset * maxFlux)
+            continue;
+
+        // Frame f ends with the hop starting at f * hopSize, which is where its rise in flux came in
+        auto position = juce::jlimit(0, numSamples - 1, f * hopSize);
+        onsets.push_back({ position, flux[size_t(f)] });
+        lastOnset = f;
+    }
+
+    return onsets;
+}
+
+std::vector<int> LoopSlicer::pickSlices(const std::vector<Onset>& onsets, int maxNumSlices)
+{
+    auto strongest = onsets;
+    auto numSlices = std::min(strongest.size(), size_t(juce::jmax(0, maxNumSlices)));
+
+    std::partial_sort(strongest.begin(), strongest.begin() + std::ptrdiff_t(numSlices), strongest.end(),
+                      [](const Onset& a, const Onset& b) { return a.strength > b.strength; });
+
+    std::vector<int> positions;
+
+    for (size_t i = 0; i < numSlices; i++)
+        positions.push_back(strongest[i].position);
+
+    std::sort(positions.begin(), positions.end());
+    return positions;
+}
+
+void LoopSlicer::cutSlices(const float* data, int numSamples, const std::vector<int>& positions, int sliceLength, float* dest)
+{
+    for (auto position : positions)
+    {
+        auto numToCopy = juce::jlimit(0, sliceLength, numSamples - position);
+
+        std::copy_n(data + position, numToCopy, dest);
+        std::fill(dest + numToCopy, dest + sliceLength, 0.0f);
+
+        dest += sliceLength;
+    }
+}
+
+std::vector<float> LoopSlicer::getSpectralFlux(const float* data, int numSamples)
+{
+    juce::dsp::FFT fft{ fftOrder };
+    juce::dsp::WindowingFunction<float> window{ size_t(fftSize), juce::dsp::WindowingFunction<float>::hann, false };
+
+    // Real-only transforms need twice the frame size for their output
+    std::vector<float> frame(size_t(2 * fftSize));
+    std::vector<float> previous(size_t(fftSize / 2 + 1), 0.0f);
+    std::vector<float> flux;
+
+    // The first frame ends with the first hop, so that a hit right at the start rises from silence
+    for (int start = hopSize - fftSize; start < numSamples; start += hopSize)
+    {
+        std::fill(frame.begin(), frame.end(), 0.0f);
+
+        auto first = juce::jmax(0, start);
+        auto last = juce::jmin(numSamples, start + fftSize);
+
+        if (last > first)
+            std::copy(data + first, data + last, frame.begin() + (first - start));
+
+        window.multiplyWithWindowingTable(frame.data(), size_t(fftSize));
+        fft.performFrequencyOnlyForwardTransform(frame.data(), true);
+
+        auto sum = 0.0f;
+
+        for (size_t k = 0; k < previous.size(); k++)
+        {
+            auto magnitude = std::log1p(compression * frame[k]);
+            sum += juce::jmax(0.0f, magnitude - previous[k]);
+            previous[k] = magnitude;
+        }
+
+        flux.push_back(sum);
+    }
+
+    return flux;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Finds the hits in a drum loop, to cut it into one-shots.
+
+    Onsets are detected by spectral flux: the loop is analysed in overlapping
+    Hann-windowed frames, and each frame's flux is the sum of the rises in its
+    log-compressed magnitude spectrum from the previous frame. A frame is an
+    onset where its flux is a local maximum that stands out from the flux
+    around it, at least minOnsetGap after the previous onset.
+*/
+class LoopSlicer
+{
+public:
+    struct Onset
+    {
+        int position{ 0 };
+        float strength{ 0.0f };
+    };
+
+    LoopSlicer() = delete;
+
+    // Onsets in a mono signal, in order
+    static std::vector<Onset> findOnsets(const float* data, int numSamples, double sampleRate);
+
+    // Positions of the strongest maxNumSlices onsets, in order
+    static std::vector<int> pickSlices(const std::vector<Onset>& onsets, int maxNumSlices);
+
+    // Copies sliceLength samples from each position, one slice after another, zero-padded past the end
+    static void cutSlices(const float* data, int numSamples, const std::vector<int>& positions, int sliceLength, float* dest);
+
+private:
+    static constexpr int fftOrder{ 10 };
+    static constexpr int fftSize{ 1 << fftOrder };
+    static constexpr int hopSize{ fftSize / 4 };
+
+    // Frames either side that a peak must beat, and that set the threshold it must clear
+    static constexpr int peakRadius{ 3 };
+    static constexpr int meanRadius{ 16 };
+
+    // Fraction of the loudest flux added to the local mean to give the threshold
+    static constexpr float thresholdOffset{ 0.1f };
+    static constexpr float compression{ 100.0f };
+    static constexpr double minOnsetGap{ 0.05 };
+
+    static std::vector<float> getSpectralFlux(const float* data, int numSamples);
+};
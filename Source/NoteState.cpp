@@ -0,0 +1,106 @@
+#include "NoteState.h"
+
+static_assert(std::atomic<juce::uint64>::is_always_lock_free, "Note state must be lock free");
+
+void NoteState::reset()
+{
+    for (auto& word : _notesOn)
+        word.store(0, std::memory_order_relaxed);
+
+    _numChanges.fetch_add(1, std::memory_order_release);
+}
+
+void NoteState::processNextMidiBuffer(juce::MidiBuffer& midi)
+{
+    // Editor notes go in at the start of the block, as MidiKeyboardState did
+    _fifo.read(_fifo.getNumReady()).forEach([&](int index)
+    {
+        midi.addEvent(_messages[size_t(index)], 0);
+    });
+
+    for (const auto metadata : midi)
+        handle(metadata.getMessage());
+}
+
+bool NoteState::noteOn(int midiChannel, int note, float velocity)
+{
+    return push(juce::MidiMessage::noteOn(midiChannel, note, velocity));
+}
+
+bool NoteState::noteOff(int midiChannel, int note)
+{
+    return push(juce::MidiMessage::noteOff(midiChannel, note));
+}
+
+NoteState::Snapshot NoteState::getSnapshot() const
+{
+    Snapshot s;
+
+    // Each word is read atomically, which is all that any one note needs
+    for (size_t i = 0; i < 2; i++)
+        s.notesOn[i] = _notesOn[i].load(std::memory_order_acquire);
+
+    return s;
+}
+
+bool NoteState::isNoteOn(int note) const
+{
+    jassert(juce::isPositiveAndBelow(note, numNotes));
+    return (_notesOn[note >> 6].load(std::memory_order_acquire) >> (note & 63)) & 1;
+}
+
+juce::uint32 NoteState::getNumHits(int note) const
+{
+    jassert(juce::isPositiveAndBelow(note, numNotes));
+    return _numHits[size_t(note)].load(std::memory_order_acquire);
+}
+
+juce::uint32 NoteState::getNumChanges() const
+{
+    return _numChanges.load(std::memory_order_acquire);
+}
+
+bool NoteState::push(const juce::MidiMessage& message)
+{
+    auto scope = _fifo.write(1);
+
+    if (scope.blockSize1 + scope.blockSize2 == 0)
+        return false;
+
+    scope.forEach([&](int index) { _messages[size_t(index)] = message; });
+    return true;
+}
+
+void NoteState::handle(const juce::MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        setNote(message.getNoteNumber(), true);
+    }
+    else if (message.isNoteOff())
+    {
+        setNote(message.getNoteNumber(), false);
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        for (auto& word : _notesOn)
+            word.store(0, std::memory_order_release);
+
+        _numChanges.fetch_add(1, std::memory_order_release);
+    }
+}
+
+void NoteState::setNote(int note, bool isOn)
+{
+    auto& word = _notesOn[note >> 6];
+    auto bit = juce::uint64(1) << (note & 63);
+
+    // Only the audio thread writes, so plain loads and stores are enough
+    auto current = word.load(std::memory_order_relaxed);
+    word.store(isOn ? (current | bit) : (current & ~bit), std::memory_order_release);
+
+    if (isOn)
+        _numHits[size_t(note)].fetch_add(1, std::memory_order_release);
+
+    _numChanges.fetch_add(1, std::memory_order_release);
+}
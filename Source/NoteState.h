@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Which notes are held, published by the audio thread without locks.
+
+    Takes the place of juce::MidiKeyboardState, whose lock is shared between
+    the audio thread and the editor polling it. Here the audio thread keeps a
+    128-bit note-on mask in two atomic words, a hit counter per note and a
+    change counter, and the editor reads them whenever it likes. A note that
+    starts and stops between two polls still moves its hit counter, so short
+    hits aren't lost.
+
+    Notes played from the editor go the other way through a single-producer
+    FIFO, and are added to the next block's MIDI at its start.
+*/
+class NoteState
+{
+public:
+    static constexpr int numNotes{ 128 };
+
+    struct Snapshot
+    {
+        juce::uint64 notesOn[2]{};
+
+        bool isNoteOn(int note) const
+        {
+            jassert(juce::isPositiveAndBelow(note, numNotes));
+            return (notesOn[note >> 6] >> (note & 63)) & 1;
+        }
+    };
+
+    NoteState() = default;
+    ~NoteState() = default;
+
+    // While the audio thread isn't running
+    void reset();
+
+    // Audio thread: adds notes from noteOn/noteOff to midi, then records every note in it
+    void processNextMidiBuffer(juce::MidiBuffer& midi);
+
+    // Message thread. Returns false, dropping the note, if the audio thread hasn't kept up.
+    bool noteOn(int midiChannel, int note, float velocity);
+    bool noteOff(int midiChannel, int note);
+
+    // Any thread
+    Snapshot getSnapshot() const;
+    bool isNoteOn(int note) const;
+    juce::uint32 getNumHits(int note) const;
+
+    // Moves whenever any note starts or stops, so an unchanged value means nothing to redraw
+    juce::uint32 getNumChanges() const;
+
+private:
+    static constexpr int fifoSize{ 256 };
+
+    bool push(const juce::MidiMessage& message);
+    void handle(const juce::MidiMessage& message);
+    void setNote(int note, bool isOn);
+
+    std::atomic<juce::uint64> _notesOn[2]{};
+    std::array<std::atomic<juce::uint32>, numNotes> _numHits{};
+    std::atomic<juce::uint32> _numChanges{ 0 };
+
+    juce::AbstractFifo _fifo{ fifoSize };
+    std::array<juce::MidiMessage, fifoSize> _messages;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NoteState)
+};
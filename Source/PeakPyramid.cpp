@@ -0,0 +1,193 @@
+#include "PeakPyramid.h"
+
+PeakPyramid::PeakPyramid(const juce::AudioBuffer<float>& source)
+    : _numSamples(source.getNumSamples())
+{
+    auto numChannels = source.getNumChannels();
+    auto numPeaks = (_numSamples + baseSamplesPerPeak - 1) / baseSamplesPerPeak;
+
+    auto& base = _levels.emplace_back(size_t(numChannels));
+
+    for (int j = 0; j < numChannels; j++)
+    {
+        auto data = source.getReadPointer(j);
+        auto& peaks = base[size_t(j)];
+        peaks.resize(size_t(numPeaks));
+
+        for (int p = 0; p < numPeaks; p++)
+        {
+            auto start = p * baseSamplesPerPeak;
+            peaks[size_t(p)] = measure(data + start, juce::jmin(baseSamplesPerPeak, _numSamples - start));
+        }
+    }
+
+    // A level's last peak can cover fewer samples than the rest, which is close enough for drawing
+    while (numPeaks > 1)
+    {
+        auto numCoarser = (numPeaks + 1) / 2;
+        std::vector<std::vector<Peak>> coarser(size_t(numChannels));
+
+        for (int j = 0; j < numChannels; j++)
+        {
+            auto& finer = _levels.back()[size_t(j)];
+            auto& peaks = coarser[size_t(j)];
+            peaks.resize(size_t(numCoarser));
+
+            for (int p = 0; p < numCoarser; p++)
+            {
+                auto i = size_t(2 * p);
+                peaks[size_t(p)] = i + 1 < finer.size() ? combine(finer[i], finer[i + 1]) : finer[i];
+            }
+        }
+
+        _levels.push_back(std::move(coarser));
+        numPeaks = numCoarser;
+    }
+}
+
+int PeakPyramid::getNumChannels() const
+{
+    return int(_levels.front().size());
+}
+
+int PeakPyramid::getNumSamples() const
+{
+    return _numSamples;
+}
+
+int PeakPyramid::getNumLevels() const
+{
+    return int(_levels.size());
+}
+
+int PeakPyramid::getSamplesPerPeak(int level) const
+{
+    jassert(juce::isPositiveAndBelow(level, getNumLevels()));
+    return baseSamplesPerPeak << level;
+}
+
+const std::vector<PeakPyramid::Peak>& PeakPyramid::getPeaks(int level, int channel) const
+{
+    jassert(juce::isPositiveAndBelow(level, getNumLevels()) && juce::isPositiveAndBelow(channel, getNumChannels()));
+    return _levels[size_t(level)][size_t(channel)];
+}
+
+PeakPyramid::Peak PeakPyramid::getPeak(int channel, int startSample, int endSample, int level) const
+{
+    auto& peaks = getPeaks(level, channel);
+
+    if (peaks.empty())
+        return {};
+
+    auto samplesPerPeak = getSamplesPerPeak(level);
+    auto first = juce::jlimit(0, int(peaks.size()) - 1, startSample / samplesPerPeak);
+    auto last = juce::jlimit(first + 1, int(peaks.size()), (endSample + samplesPerPeak - 1) / samplesPerPeak);
+
+    auto result = peaks[size_t(first)];
+    auto sumOfSquares = result.rms * result.rms;
+
+    for (auto p = size_t(first + 1); p < size_t(last); p++)
+    {
+        result.min = juce::jmin(result.min, peaks[p].min);
+        result.max = juce::jmax(result.max, peaks[p].max);
+        sumOfSquares += peaks[p].rms * peaks[p].rms;
+    }
+
+    result.rms = std::sqrt(sumOfSquares / float(last - first));
+    return result;
+}
+
+int PeakPyramid::getLevelFor(double samplesPerPixel) const
+{
+    int level = 0;
+
+    while (level + 1 < getNumLevels() && getSamplesPerPeak(level + 1) <= samplesPerPixel)
+        level++;
+
+    return level;
+}
+
+void PeakPyramid::drawChannels(juce::Graphics& g, juce::Rectangle<int> area, int startSample, int endSample, float verticalZoomFactor) const
+{
+    auto numChannels = getNumChannels();
+    auto width = area.getWidth();
+
+    if (numChannels == 0 || width <= 0 || endSample <= startSample || _numSamples == 0)
+        return;
+
+    auto samplesPerPixel = double(endSample - startSample) / double(width);
+    auto level = getLevelFor(samplesPerPixel);
+    auto colour = g.getCurrentColour();
+
+    juce::RectangleList<float> peakRects, rmsRects;
+
+    for (int j = 0; j < numChannels; j++)
+    {
+        auto strip = area.withTrimmedTop(area.getHeight() * j / numChannels)
+                         .withHeight(area.getHeight() / numChannels)
+                         .toFloat();
+        auto centre = strip.getCentreY();
+        auto scale = 0.5f * strip.getHeight() * verticalZoomFactor;
+
+        for (int x = 0; x < width; x++)
+        {
+            auto s0 = startSample + int(x * samplesPerPixel);
+            auto s1 = juce::jmax(s0 + 1, startSample + int((x + 1) * samplesPerPixel));
+            auto peak = getPeak(j, s0, s1, level);
+
+            auto top = centre - juce::jlimit(-1.0f, 1.0f, peak.max) * scale;
+            auto bottom = centre - juce::jlimit(-1.0f, 1.0f, peak.min) * scale;
+            auto rms = juce::jmin(1.0f, peak.rms) * scale;
+            auto left = strip.getX() + float(x);
+
+            // At least a pixel high, so that silence still draws a line
+            peakRects.addWithoutMerging({ left, top, 1.0f, juce::jmax(1.0f, bottom - top) });
+            rmsRects.addWithoutMerging({ left, centre - rms, 1.0f, 2.0f * rms });
+        }
+    }
+
+    g.setColour(colour.withMultipliedAlpha(0.5f));
+    g.fillRectList(peakRects);
+
+    g.setColour(colour);
+    g.fillRectList(rmsRects);
+}
+
+PeakPyramid::Peak PeakPyramid::measure(const float* data, int numSamples)
+{
+    Peak result;
+
+    if (numSamples <= 0)
+        return result;
+
+    auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+    result.min = range.getStart();
+    result.max = range.getEnd();
+
+    // Independent partial sums, so the loop vectorises
+    constexpr int numAccumulators = 8;
+    float sums[numAccumulators] = {};
+    int i = 0;
+
+    for (; i + numAccumulators <= numSamples; i += numAccumulators)
+        for (int k = 0; k < numAccumulators; k++)
+            sums[k] += data[i + k] * data[i + k];
+
+    for (; i < numSamples; i++)
+        sums[0] += data[i] * data[i];
+
+    float sumOfSquares = 0.0f;
+
+    for (auto s : sums)
+        sumOfSquares += s;
+
+    result.rms = std::sqrt(sumOfSquares / float(numSamples));
+    return result;
+}
+
+PeakPyramid::Peak PeakPyramid::combine(const Peak& a, const Peak& b)
+{
+    return { juce::jmin(a.min, b.min),
+             juce::jmax(a.max, b.max),
+             std::sqrt(0.5f * (a.rms * a.rms + b.rms * b.rms)) };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Min, max and RMS of a buffer at a range of resolutions, for drawing waveforms.
+
+    The finest level has a peak for every baseSamplesPerPeak samples, and each
+    level above it combines pairs from the one below, up to a single peak for
+    the whole buffer. Drawing picks the coarsest level that still has at least
+    one peak per pixel, so it costs about one peak per pixel at any zoom and
+    never touches the audio.
+
+    Built once from the audio and read-only afterwards, so it can be shared
+    between threads.
+*/
+class PeakPyramid
+{
+public:
+    static constexpr int baseSamplesPerPeak{ 16 };
+
+    struct Peak
+    {
+        float min{ 0.0f };
+        float max{ 0.0f };
+        float rms{ 0.0f };
+    };
+
+    explicit PeakPyramid(const juce::AudioBuffer<float>& source);
+    ~PeakPyramid() = default;
+
+    int getNumChannels() const;
+    int getNumSamples() const;
+
+    int getNumLevels() const;
+    int getSamplesPerPeak(int level) const;
+    const std::vector<Peak>& getPeaks(int level, int channel) const;
+
+    // The peaks of one level covering a range of samples, combined
+    Peak getPeak(int channel, int startSample, int endSample, int level) const;
+
+    // The coarsest level with at least one peak per pixel
+    int getLevelFor(double samplesPerPixel) const;
+
+    // Draws each channel in its own horizontal strip, the peaks faintly behind the RMS, in the current colour
+    void drawChannels(juce::Graphics& g, juce::Rectangle<int> area, int startSample, int endSample, float verticalZoomFactor) const;
+
+private:
+    static Peak measure(const float* data, int numSamples);
+    static Peak combine(const Peak& a, const Peak& b);
+
+    int _numSamples{ 0 };
+
+    // Indexed by level, then channel
+    std::vector<std::vector<std::vector<Peak>>> _levels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PeakPyramid)
+};
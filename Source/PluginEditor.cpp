@@ -28,7 +28,7 @@ CrasshhfyAudioProcessorEditor::CrasshhfyAudioProcessorEditor(CrasshhfyAudioProce
 		auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
 		auto idx = _lastNoteIndex;
 
-        _chooser = std::make_unique<juce::FileChooser>("Load wav file", defaultPath, "*.wav");
+        _chooser = std::make_unique<juce::FileChooser>("Load audio file", defaultPath, _processor.getInputFileWildcard());
         _chooser->launchAsync(flags, [this, idx](const juce::FileChooser& chooser) {
             auto f = chooser.getResult();
 
@@ -47,6 +47,78 @@ CrasshhfyAudioProcessorEditor::CrasshhfyAudioProcessorEditor(CrasshhfyAudioProce
 	};
 	addAndMakeVisible(_drumifyButton);
 
+	// Drumify a loop onto every pad
+	_sliceLoopButton.setButtonText("Slice Loop");
+	_sliceLoopButton.onClick = [this]
+	{
+		auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles;
+		auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
+
+		_chooser = std::make_unique<juce::FileChooser>("Load drum loop", defaultPath, _processor.getInputFileWildcard());
+		_chooser->launchAsync(flags, [this](const juce::FileChooser& chooser) {
+			auto f = chooser.getResult();
+
+			if (f == juce::File())
+				return;
+
+			setButtonsEnabled(false);
+			juce::Thread::launch([this, f] {
+				_processor.drumifyLoop(f);
+				juce::MessageManager::callAsync([this] { setButtonsEnabled(true); });
+			});
+		});
+	};
+	addAndMakeVisible(_sliceLoopButton);
+
+	// Pick a kit from a folder of one-shots
+	_folderKitButton.setButtonText("Folder Kit");
+	_folderKitButton.onClick = [this]
+	{
+		auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories;
+		auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
+
+		_chooser = std::make_unique<juce::FileChooser>("Choose a folder of samples", defaultPath);
+		_chooser->launchAsync(flags, [this](const juce::FileChooser& chooser) {
+			auto f = chooser.getResult();
+
+			if (!f.isDirectory())
+				return;
+
+			setButtonsEnabled(false);
+			juce::Thread::launch([this, f] {
+				_processor.buildKitFromFolder(f);
+				juce::MessageManager::callAsync([this] { setButtonsEnabled(true); });
+			});
+		});
+	};
+	addAndMakeVisible(_folderKitButton);
+
+	// Write every pad to a folder, with the kit's metadata alongside
+	_saveKitButton.setButtonText("Save Kit");
+	_saveKitButton.onClick = [this]
+	{
+		showExportFormatMenu(_saveKitButton, [this](SampleExporter::Format format)
+		{
+			auto flags = juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectDirectories;
+			auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
+
+			_chooser = std::make_unique<juce::FileChooser>("Save kit to folder", defaultPath);
+			_chooser->launchAsync(flags, [this, format](const juce::FileChooser& chooser) {
+				auto f = chooser.getResult();
+
+				if (f == juce::File())
+					return;
+
+				_processor.saveKit(f, format, [](bool isSaved)
+				{
+					if (!isSaved)
+						juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Save Kit", "Some of the kit couldn't be written.");
+				});
+			});
+		});
+	};
+	addAndMakeVisible(_saveKitButton);
+
 	// Inpaint sample
 	_inpaintButton.setButtonText("Variation");
     _inpaintSelector.setButtonText("Start/End");
@@ -56,7 +128,7 @@ CrasshhfyAudioProcessorEditor::CrasshhfyAudioProcessorEditor(CrasshhfyAudioProce
         auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
         auto idx = _lastNoteIndex;
 
-        _chooser = std::make_unique<juce::FileChooser>("Load wav file", defaultPath, "*.wav");
+        _chooser = std::make_unique<juce::FileChooser>("Load audio file", defaultPath, _processor.getInputFileWildcard());
         _chooser->launchAsync(flags, [this, idx](const juce::FileChooser& chooser) {
             auto f = chooser.getResult();
 
@@ -87,8 +159,44 @@ CrasshhfyAudioProcessorEditor::CrasshhfyAudioProcessorEditor(CrasshhfyAudioProce
 	_stepsLabel.setText("Steps", juce::dontSendNotification);
 	addAndMakeVisible(_stepsLabel);
 
+	// Interpolation used for pitched playback, ids offset by one from InterpolationQuality
+	_qualityBox.addItemList({ "Linear", "Hermite", "Sinc" }, 1);
+	_qualityBox.setSelectedId(int(p.getInterpolationQuality()) + 1, juce::dontSendNotification);
+	_qualityBox.onChange = [this] { _processor.setInterpolationQuality(static_cast<InterpolationQuality>(_qualityBox.getSelectedId() - 1)); };
+	addAndMakeVisible(_qualityBox);
+
+	_qualityLabel.setText("Interpolation", juce::dontSendNotification);
+	addAndMakeVisible(_qualityLabel);
+
+	// Browse the library in place of the pad's controls, loading a drum onto the pad when clicked
+	_libraryBrowser.reset(new LibraryBrowser(p.getLibrary()));
+	_libraryBrowser->onEntryChosen = [this](int entry)
+	{
+		setButtonsEnabled(false);
+		auto idx = _lastNoteIndex;
+		juce::Thread::launch([this, idx, entry] {
+			_processor.loadFromLibrary(idx, entry);
+			juce::MessageManager::callAsync([this] { setButtonsEnabled(true); });
+		});
+	};
+	addChildComponent(*_libraryBrowser);
+
+	_libraryButton.setButtonText("Library");
+	_libraryButton.setClickingTogglesState(true);
+	_libraryButton.onClick = [this]
+	{
+		if (_libraryButton.getToggleState())
+		{
+			auto drumType = _processor.getSound(_lastNoteIndex)->getDrumType();
+			_libraryBrowser->showType(drumType != DrumType::none ? drumType : DrumType::kick);
+		}
+
+		updateParameterView();
+	};
+	addAndMakeVisible(_libraryButton);
+
 	// On-screen keyboard
-	_keyboard.reset(new SampleKeyboard(p.baseMidiNote, p.numSounds, p.getMidiKeyboardState()));
+	_keyboard.reset(new SampleKeyboard(p.baseMidiNote, p.numSounds, p.getNoteState()));
 	_keyboard->onSelectedNoteChange = [this](int noteIndex) 
 	{ 
 		_lastNoteIndex = noteIndex; 
@@ -101,7 +209,18 @@ CrasshhfyAudioProcessorEditor::CrasshhfyAudioProcessorEditor(CrasshhfyAudioProce
 		auto s = p.getSound(i);
 
 		// Set up parameter controls for the sample
-		addChildComponent(_parameterViews.add(new ParameterView(s)));
+		auto view = _parameterViews.add(new ParameterView(s));
+		view->onChokeGroupChange = [this, i](int group) { _processor.setChokeGroup(i, group); };
+		view->onFindSimilar = [this, i] { showSimilar(i); };
+		view->onSave = [this, i](const juce::File& f, SampleExporter::Format format)
+		{
+			_processor.saveSample(i, f, format, [](bool isSaved)
+			{
+				if (!isSaved)
+					juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::WarningIcon, "Save", "The sample couldn't be written.");
+			});
+		};
+		addChildComponent(view);
 
 		// Change note label depending on classifier output
 		s->drumChanged = [this, i, s] 
@@ -124,7 +243,7 @@ CrasshhfyAudioProcessorEditor::CrasshhfyAudioProcessorEditor(CrasshhfyAudioProce
 	
 	updateParameterView();
 
-    setSize(600, 400);
+    setSize(600, 430);
 }
 
 CrasshhfyAudioProcessorEditor::~CrasshhfyAudioProcessorEditor()
@@ -144,17 +263,21 @@ void CrasshhfyAudioProcessorEditor::resized()
 
 	auto top = bounds.removeFromTop(80);
 	auto mid = bounds.removeFromTop(185).reduced(10);
+	auto footer = bounds.removeFromBottom(30).reduced(10, 5);
 	auto bottom = bounds;
 
 	_logoBounds = top.removeFromLeft(120);
 	_logo = juce::ImageCache::getFromMemory(BinaryData::logo_png, BinaryData::logo_pngSize).rescaled(120, 120);
 
-	auto buttonSectionWidth = top.getWidth() / 3;
+	auto buttonSectionWidth = top.getWidth() / 4;
 	auto generateBounds = top.removeFromLeft(buttonSectionWidth).withSizeKeepingCentre(100, 30);
     _generateButton.setBounds(generateBounds);
+	_saveKitButton.setBounds(generateBounds.translated(0, 40));
 	_drumifyButton.setBounds(generateBounds.translated(buttonSectionWidth, 0));
 	_inpaintButton.setBounds(generateBounds.translated(2 * buttonSectionWidth, 0));
     _inpaintSelector.setBounds(generateBounds.translated(2 * buttonSectionWidth, 40));
+	_sliceLoopButton.setBounds(generateBounds.translated(3 * buttonSectionWidth, 0));
+	_folderKitButton.setBounds(generateBounds.translated(3 * buttonSectionWidth, 40));
 	_stepsSlider.setBounds(generateBounds.translated(buttonSectionWidth, 40));
 	_stepsLabel.setBounds(_stepsSlider.getBounds().translated(-45, 0).withSize(45, 20));
 
@@ -162,17 +285,97 @@ void CrasshhfyAudioProcessorEditor::resized()
 
 	for (auto view : _parameterViews)
 		view->setBounds(bottom);
+
+	_libraryBrowser->setBounds(bottom);
+	_libraryButton.setBounds(footer.removeFromRight(100));
+
+	_qualityLabel.setBounds(footer.removeFromLeft(80));
+	_qualityBox.setBounds(footer.removeFromLeft(100));
+}
+
+void CrasshhfyAudioProcessorEditor::mouseDown(const juce::MouseEvent& e)
+{
+	// Debugging options are kept out of the way, on a right-click of the logo
+	if (e.mods.isPopupMenu() && _logoBounds.contains(e.getPosition()))
+		showDebugMenu();
+}
+
+void CrasshhfyAudioProcessorEditor::showDebugMenu()
+{
+	juce::PopupMenu menu;
+	menu.addItem("Dump Tensors...", true, _processor.isTensorDumpEnabled(), [this]
+	{
+		if (_processor.isTensorDumpEnabled())
+		{
+			_processor.disableTensorDump();
+			return;
+		}
+
+		auto flags = juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectDirectories;
+		auto defaultPath = juce::File::getSpecialLocation(juce::File::SpecialLocationType::userDesktopDirectory);
+
+		_chooser = std::make_unique<juce::FileChooser>("Dump tensors to folder", defaultPath);
+		_chooser->launchAsync(flags, [this](const juce::FileChooser& chooser) {
+			auto f = chooser.getResult();
+
+			if (f.isDirectory())
+				_processor.enableTensorDump(f);
+		});
+	});
+
+	menu.showMenuAsync(juce::PopupMenu::Options().withMousePosition());
 }
 
 void CrasshhfyAudioProcessorEditor::updateParameterView()
 {
+	auto isBrowsing = _libraryButton.getToggleState();
+	_libraryBrowser->setVisible(isBrowsing);
+
 	for (int i = 0; i < _parameterViews.size(); i++)
-		_parameterViews[i]->setVisible(i == _lastNoteIndex);
+	{
+		// Refreshed on showing, as a restored state may have changed it
+		if (i == _lastNoteIndex)
+			_parameterViews[i]->setChokeGroup(_processor.getChokeGroup(i));
+
+		_parameterViews[i]->setVisible(i == _lastNoteIndex && !isBrowsing);
+	}
+}
+
+void CrasshhfyAudioProcessorEditor::showSimilar(int soundIndex)
+{
+	static constexpr int maxNumSimilar = 20;
+
+	// Runs the classifier, so it is kept off the message thread like generating
+	setButtonsEnabled(false);
+	juce::Thread::launch([this, soundIndex] {
+		auto entries = _processor.findSimilarInLibrary(soundIndex, maxNumSimilar);
+
+		juce::MessageManager::callAsync([this, soundIndex, entries] {
+			setButtonsEnabled(true);
+
+			if (entries.isEmpty())
+			{
+				juce::AlertWindow::showMessageBoxAsync(juce::MessageBoxIconType::InfoIcon, "Similar", "There are no drums like this one in the library yet.");
+				return;
+			}
+
+			// Loaded through the browser onto whichever pad is selected, by default this one
+			_libraryBrowser->showEntries(entries, "Like " + juce::MidiMessage::getMidiNoteName(_processor.baseMidiNote + soundIndex, true, true, 4));
+			_libraryButton.setToggleState(true, juce::dontSendNotification);
+			updateParameterView();
+		});
+	});
 }
 
 void CrasshhfyAudioProcessorEditor::setButtonsEnabled(bool enabled)
 {
 	_generateButton.setEnabled(enabled);
 	_drumifyButton.setEnabled(enabled);
+	_sliceLoopButton.setEnabled(enabled);
+	_folderKitButton.setEnabled(enabled);
 	_inpaintButton.setEnabled(enabled);
+	_libraryBrowser->setEnabled(enabled);
+
+	for (auto view : _parameterViews)
+		view->setSimilarEnabled(enabled);
 }
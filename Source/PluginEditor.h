@@ -13,9 +13,12 @@ public:
 
     void paint (juce::Graphics&) override;
     void resized() override;
+    void mouseDown (const juce::MouseEvent&) override;
 
 private:
 	void updateParameterView();
+	void showSimilar(int soundIndex);
+	void showDebugMenu();
     void setButtonsEnabled(bool enabled);
 
     CrasshhfyAudioProcessor& _processor;
@@ -24,14 +27,21 @@ private:
 
     juce::TextButton _generateButton;
     juce::TextButton _drumifyButton;
+    juce::TextButton _sliceLoopButton;
+    juce::TextButton _folderKitButton;
+    juce::TextButton _saveKitButton;
     juce::TextButton _inpaintButton;
     juce::Label _inpaintText;
     juce::ToggleButton _inpaintSelector;
     juce::Slider _stepsSlider;
     juce::Label _stepsLabel;
+    juce::ComboBox _qualityBox;
+    juce::Label _qualityLabel;
+    juce::TextButton _libraryButton;
 
 	std::unique_ptr<SampleKeyboard> _keyboard;
 	juce::OwnedArray<ParameterView> _parameterViews;
+	std::unique_ptr<LibraryBrowser> _libraryBrowser;
 	int _lastNoteIndex{ 0 };
 
 	std::unique_ptr<juce::FileChooser> _chooser;
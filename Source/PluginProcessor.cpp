@@ -1,23 +1,37 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
-CrasshhfyAudioProcessor::CrasshhfyAudioProcessor()
+CrasshhfyAudioProcessor::CrasshhfyAudioProcessor(const Layout& layout)
   : AudioProcessor(BusesProperties().withOutput("Output", juce::AudioChannelSet::stereo(), true)),
+    numSounds(layout.numSounds),
+    numVoices(layout.numVoices),
+    baseMidiNote(layout.baseMidiNote),
     _parameters(*this, nullptr, "PARAMS", createParameterLayout())
 {
+    jassert(numSounds > 0 && numVoices > 0);
+    jassert(baseMidiNote >= 0 && baseMidiNote + numSounds <= DrumSynthesiser::numMidiNotes);
+
+    // Keep resampled samples on disk so that reopening a project can skip resampling
+    auto cacheDir = juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+                        .getChildFile(JucePlugin_Name)
+                        .getChildFile("SampleCache");
+    _sampleCache->setDiskCacheDirectory(cacheDir);
+
     for (int i = 0; i < numSounds; i++)
     {
-        auto sound = new DrumSound(baseMidiNote + i);
+        auto sound = new DrumSound(baseMidiNote + i, _parameters, i);
         _sounds.push_back(sound);
-        _synth.addSound(sound);
+        _synth.addDrumSound(sound);
     }
 
     for (int i = 0; i < numVoices; i++)
     {
         auto voice = new Voice();
         _voices.push_back(voice);
-        _synth.addVoice(voice);
+        _synth.addDrumVoice(voice);
     }
+
+    _synth.setMaxVoicesPerPad(layout.maxVoicesPerPad);
 }
 
 CrasshhfyAudioProcessor::~CrasshhfyAudioProcessor()
@@ -34,26 +48,31 @@ bool CrasshhfyAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts)
 
 void CrasshhfyAudioProcessor::prepareToPlay(double sampleRate, int)
 {
-    // Unused functionality but the Synthesiser class requires a real sample rate value
-    _synth.setCurrentPlaybackSampleRate(sampleRate);
+    // Sample rates are handled by the Sound class
+    for (auto s : _sounds)
+        s->setSampleRate(sampleRate);
 
-    // Sample rates are actually handled by the Sound class
-    for (int i = 0; i < _synth.getNumSounds(); i++)
-        if (auto s = dynamic_cast<Sound*>(_synth.getSound(i).get()))
-            s->setSampleRate(sampleRate);
-
-    _midiState.reset();
+    _noteState.reset();
 }
 
 void CrasshhfyAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
 {
     juce::ScopedNoDenormals noDenormals;
 
-    _midiState.processNextMidiBuffer(midi, 0, buffer.getNumSamples(), true);
+    _noteState.processNextMidiBuffer(midi);
+
+    for (auto s : _sounds)
+    {
+        s->beginBlock();
+        s->updateParameters(buffer.getNumSamples());
+    }
 
     buffer.clear();
     _synth.renderNextBlock(buffer, midi, 0, buffer.getNumSamples());
 
+    for (auto s : _sounds)
+        s->endBlock();
+
     midi.clear();
 }
 
@@ -61,12 +80,127 @@ void CrasshhfyAudioProcessor::releaseResources()
 {
 }
 
-void CrasshhfyAudioProcessor::getStateInformation (juce::MemoryBlock&)
+void CrasshhfyAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    juce::ValueTree state{ "CrasshhfyState" };
+    state.setProperty("version", 1, nullptr);
+    state.setProperty("interpolationQuality", int(_interpolationQuality), nullptr);
+    state.appendChild(_parameters.copyState(), nullptr);
+
+    {
+        const juce::ScopedLock sl(_stateLock);
+
+        if (_pendingPads.isValid())
+        {
+            state.appendChild(_pendingPads.createCopy(), nullptr);
+        }
+        else
+        {
+            juce::ValueTree pads{ "Pads" };
+
+            for (int i = 0; i < numSounds; i++)
+                pads.appendChild(createPadState(i), nullptr);
+
+            state.appendChild(pads, nullptr);
+        }
+    }
+
+    // Binary rather than XML, so that the compressed audio is stored as it is
+    juce::MemoryOutputStream stream{ destData, false };
+    state.writeToStream(stream);
+}
+
+void CrasshhfyAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    auto state = juce::ValueTree::readFromData(data, size_t(sizeInBytes));
+
+    if (!state.hasType("CrasshhfyState"))
+        return;
+
+    auto parameters = state.getChildWithName(_parameters.state.getType());
+    if (parameters.isValid())
+        _parameters.replaceState(parameters);
+
+    // States saved before it could be set keep the default
+    auto quality = int(state.getProperty("interpolationQuality", int(InterpolationQuality::sinc)));
+    setInterpolationQuality(static_cast<InterpolationQuality>(juce::jlimit(0, int(InterpolationQuality::sinc), quality)));
+
+    auto pads = state.getChildWithName("Pads");
+    if (!pads.isValid())
+        return;
+
+    int generation;
+    {
+        const juce::ScopedLock sl(_stateLock);
+        _pendingPads = pads;
+        generation = ++_stateGeneration;
+    }
+
+    // Decoding and resampling happen in the background, so that the host isn't held up
+    _statePool.addJob([this, pads, generation] { restorePads(pads, generation); });
+}
+
+juce::ValueTree CrasshhfyAudioProcessor::createPadState(int soundIndex)
 {
+    auto sound = getSound(soundIndex);
+
+    juce::ValueTree pad{ "Pad" };
+    pad.setProperty("index", soundIndex, nullptr);
+    pad.setProperty("drumType", int(sound->getDrumType()), nullptr);
+    pad.setProperty("confidence", sound->getConfidence(), nullptr);
+    pad.setProperty("chokeGroup", getChokeGroup(soundIndex), nullptr);
+
+    // The hash is saved as well, as the restored audio is quantised and would hash differently
+    if (auto sample = sound->getSourceSample())
+    {
+        pad.setProperty("audio", sample->getEncoded(), nullptr);
+        pad.setProperty("hash", sample->getHash(), nullptr);
+    }
+
+    return pad;
 }
 
-void CrasshhfyAudioProcessor::setStateInformation (const void*, int)
+void CrasshhfyAudioProcessor::restorePads(juce::ValueTree pads, int generation)
 {
+    auto isCurrent = [this, generation]
+    {
+        const juce::ScopedLock sl(_stateLock);
+        return generation == _stateGeneration;
+    };
+
+    for (auto pad : pads)
+    {
+        // A newer state has been set, which restores every pad itself
+        if (!isCurrent())
+            return;
+
+        auto index = int(pad.getProperty("index", -1));
+        if (!juce::isPositiveAndBelow(index, numSounds))
+            continue;
+
+        setChokeGroup(index, int(pad.getProperty("chokeGroup", 0)));
+
+        Drum d;
+        d.drumType = static_cast<DrumType>(int(pad.getProperty("drumType", 0)));
+        d.confidence = float(pad.getProperty("confidence", 0.0f));
+
+        if (auto audio = pad.getProperty("audio").getBinaryData())
+        {
+            auto [data, fs] = Utils::decodeFlac(*audio);
+
+            // States saved before the hash was kept hash the restored audio instead
+            if (data.getNumSamples() > 0)
+                d.sample = pad.hasProperty("hash") ? new Sample{ std::move(data), fs, juce::int64(pad.getProperty("hash")) }
+                                                   : new Sample{ std::move(data), fs };
+        }
+
+        getSound(index)->loadDrum(d);
+    }
+
+    const juce::ScopedLock sl(_stateLock);
+
+    if (generation == _stateGeneration)
+        _pendingPads = {};
 }
 
 bool CrasshhfyAudioProcessor::hasEditor() const
@@ -79,9 +213,9 @@ juce::AudioProcessorEditor* CrasshhfyAudioProcessor::createEditor()
     return new CrasshhfyAudioProcessorEditor (*this);
 }
 
-juce::MidiKeyboardState& CrasshhfyAudioProcessor::getMidiKeyboardState()
+NoteState& CrasshhfyAudioProcessor::getNoteState()
 {
-    return _midiState;
+    return _noteState;
 }
 
 DrumSound* CrasshhfyAudioProcessor::getSound(int soundIndex)
@@ -90,12 +224,85 @@ DrumSound* CrasshhfyAudioProcessor::getSound(int soundIndex)
     return _sounds[soundIndex];
 }
 
-void CrasshhfyAudioProcessor::saveSample(int soundIndex, const juce::File& file)
+void CrasshhfyAudioProcessor::saveSample(int soundIndex, const juce::File& file, SampleExporter::Format format, std::function<void(bool)> onDone)
+{
+    std::vector<SampleExporter::Item> items;
+
+    if (auto sample = getSound(soundIndex)->getSourceSample())
+        items.push_back({ file, sample, {} });
+
+    _exporter->write(std::move(items), format, std::move(onDone));
+}
+
+void CrasshhfyAudioProcessor::saveKit(const juce::File& folder, SampleExporter::Format format, std::function<void(bool)> onDone)
 {
-    auto sample = getSound(soundIndex)->getSample();
+    if (!folder.createDirectory())
+    {
+        if (onDone != nullptr)
+            juce::MessageManager::callAsync([onDone] { onDone(false); });
+
+        return;
+    }
+
+    std::vector<SampleExporter::Item> items;
+    juce::Array<juce::var> pads;
+
+    for (int i = 0; i < numSounds; i++)
+    {
+        auto sound = getSound(i);
+        auto sample = sound->getSourceSample();
+
+        if (sample == nullptr)
+            continue;
+
+        juce::String drumType;
+
+        switch (sound->getDrumType())
+        {
+            case DrumType::kick:    drumType = "kick";  break;
+            case DrumType::snare:   drumType = "snare"; break;
+            case DrumType::hat:     drumType = "hat";   break;
+            case DrumType::none:    break;
+        }
+
+        auto name = juce::String::formatted("Pad %02d", i + 1);
+
+        if (drumType.isNotEmpty())
+            name << " " << drumType.substring(0, 1).toUpperCase() << drumType.substring(1);
+
+        auto file = folder.getChildFile(juce::File::createLegalFileName(name) + ".wav");
+        items.push_back({ file, sample, {} });
+
+        // Parameter values in their own units, as they're shown on the pad
+        auto parameters = new juce::DynamicObject();
+
+        for (int p = 0; p < SoundWithParameters::kNumParameters; p++)
+        {
+            auto param = sound->getParameter(p);
+            parameters->setProperty(SoundWithParameters::getDefinition(p).id, param->convertFrom0to1(param->getValue()));
+        }
+
+        auto pad = new juce::DynamicObject();
+        pad->setProperty("index", i);
+        pad->setProperty("midiNote", sound->getMidiNote());
+        pad->setProperty("file", file.getFileName());
+        pad->setProperty("drumType", drumType);
+        pad->setProperty("confidence", sound->getConfidence());
+        pad->setProperty("sampleRate", sample->sampleRate);
+        pad->setProperty("numChannels", sample->data.getNumChannels());
+        pad->setProperty("numSamples", sample->data.getNumSamples());
+        pad->setProperty("parameters", juce::var(parameters));
+        pads.add(juce::var(pad));
+    }
 
-    if (sample != nullptr)
-        Utils::writeWavFile(sample->data, sample->sampleRate, file);
+    auto kit = new juce::DynamicObject();
+    kit->setProperty("bitDepth", SampleExporter::getNumBits(format));
+    kit->setProperty("isFloat", format == SampleExporter::Format::float32);
+    kit->setProperty("pads", pads);
+
+    items.push_back({ folder.getChildFile("kit.json"), nullptr, juce::JSON::toString(juce::var(kit)) });
+
+    _exporter->write(std::move(items), format, std::move(onDone));
 }
 
 void CrasshhfyAudioProcessor::generateSample(int soundIndex)
@@ -104,78 +311,283 @@ void CrasshhfyAudioProcessor::generateSample(int soundIndex)
     size_t classification = 0;
     float confidence = 0;
 
+    const juce::ScopedLock il(_inferenceLock);
+
     unetModelInference.process(data.getWritePointer(0), _numSteps);
-    classifierModelInference.process(data.getReadPointer(0), &classification, &confidence);
 
+    // Classified as stored, so that its embedding compares with those of drums searched for later
     Utils::normalize(data);
     data.applyGain(juce::Decibels::decibelsToGain(-3.0f));
-    
-    // 0 = Kick, 1 = Hat, 2 = Snare
-    Drum d;
-    d.sample = new Sample{ std::move(data), UnetModelInference::sampleRate };
-    d.drumType = static_cast<DrumType>(classification + 1);
-    d.confidence = confidence;
+    classifierModelInference.process(data.getReadPointer(0), &classification, &confidence);
 
+    auto d = storeGenerated(std::move(data), classification, confidence, unetModelInference.getLastSeed(),
+                            classifierModelInference.getEmbedding());
     getSound(soundIndex)->loadDrum(d);
 }
 
+Drum CrasshhfyAudioProcessor::storeGenerated(juce::AudioBuffer<float>&& data, size_t classification, float confidence,
+                                             juce::uint32 seed, std::vector<float> embedding)
+{
+    // 0 = Kick, 1 = Hat, 2 = Snare
+    DrumLibrary::Entry entry;
+    entry.drumType = static_cast<DrumType>(classification + 1);
+    entry.confidence = confidence;
+    entry.seed = seed;
+    entry.time = juce::Time::currentTimeMillis();
+
+    // Played from the library file when it could be stored there
+    auto index = _library->add(data, entry, embedding);
+    auto d = _library->load(index);
+
+    if (d.sample == nullptr)
+    {
+        d.sample = new Sample{ std::move(data), UnetModelInference::sampleRate };
+        d.drumType = entry.drumType;
+        d.confidence = entry.confidence;
+    }
+
+    return d;
+}
+
+void CrasshhfyAudioProcessor::loadFromLibrary(int soundIndex, int entryIndex)
+{
+    auto d = _library->load(entryIndex);
+
+    if (d.sample != nullptr)
+        getSound(soundIndex)->loadDrum(d);
+}
+
+DrumLibrary& CrasshhfyAudioProcessor::getLibrary()
+{
+    return *_library;
+}
+
+juce::Array<int> CrasshhfyAudioProcessor::findSimilarInLibrary(int soundIndex, int maxResults)
+{
+    auto sample = getSound(soundIndex)->getSourceSample();
+
+    if (sample == nullptr || classifierModelInference.getEmbeddingSize() == 0)
+        return {};
+
+    // A drum from the library is searched for by its stored embedding, which leaves the drum itself out
+    auto entry = _library->findEntry(sample->getHash());
+
+    if (entry >= 0)
+        return _library->findSimilar(entry, maxResults);
+
+    // Other drums, such as those from a folder, are classified as they are, as library drums were when stored.
+    // The classifier takes the start of the drum, mixed to mono.
+    auto& source = sample->data;
+    auto numSamples = juce::jmin(source.getNumSamples(), ClassifierModelInference::inputSize);
+
+    juce::AudioBuffer<float> input{ 1, ClassifierModelInference::inputSize };
+    input.clear();
+
+    for (int j = 0; j < source.getNumChannels(); j++)
+        input.addFrom(0, 0, source, j, 0, numSamples, 1.0f / float(source.getNumChannels()));
+
+    size_t classification = 0;
+    float confidence = 0;
+
+    const juce::ScopedLock il(_inferenceLock);
+    classifierModelInference.process(input.getReadPointer(0), &classification, &confidence);
+
+    return _library->findSimilar(classifierModelInference.getEmbedding(), maxResults);
+}
+
+juce::String CrasshhfyAudioProcessor::getInputFileWildcard() const
+{
+    return _loader.getWildcardForAllFormats();
+}
+
+juce::AudioBuffer<float> CrasshhfyAudioProcessor::loadInputFile(const juce::File& file, bool startAtOnset)
+{
+    static_assert(UnetModelInference::numChannels == 1, "Inputs are mixed to mono");
+
+    AudioFileLoader::Options options;
+    options.numSamples = UnetModelInference::outputSize;
+    options.sampleRate = UnetModelInference::sampleRate;
+    options.startAtOnset = startAtOnset;
+    options.mono = true;
+
+    return _loader.load(file, options);
+}
+
 void CrasshhfyAudioProcessor::drumifySample(int soundIndex, const juce::File& file)
 {
-    auto [inputData, fs] = Utils::readWavFile(file);
+    auto inputData = loadInputFile(file, true);
 
     if (inputData.getNumSamples() == 0)
         return;
 
-    inputData.setSize(UnetModelInference::numChannels, UnetModelInference::outputSize, true, true);
-
     juce::AudioBuffer<float> outputData{ UnetModelInference::numChannels, UnetModelInference::outputSize };
     size_t classification = 0;
     float confidence = 0;
 
     Utils::normalize(inputData);
 
+    const juce::ScopedLock il(_inferenceLock);
+
     unetModelInference.processSeeded(outputData.getWritePointer(0), inputData.getReadPointer(0), _numSteps);
-    classifierModelInference.process(outputData.getReadPointer(0), &classification, &confidence);
 
     Utils::normalize(outputData);
     outputData.applyGain(juce::Decibels::decibelsToGain(-3.0f));
-    
-    // 0 = Kick, 1 = Hat, 2 = Snare
-    Drum d;
-    d.sample = new Sample{ std::move(outputData), UnetModelInference::sampleRate };
-    d.drumType = static_cast<DrumType>(classification + 1);
-    d.confidence = confidence;
+    classifierModelInference.process(outputData.getReadPointer(0), &classification, &confidence);
 
+    auto d = storeGenerated(std::move(outputData), classification, confidence, 0, classifierModelInference.getEmbedding());
     getSound(soundIndex)->loadDrum(d);
 }
 
+void CrasshhfyAudioProcessor::drumifyLoop(const juce::File& file)
+{
+    constexpr int sliceLength = UnetModelInference::outputSize;
+
+    AudioFileLoader::Options options;
+    options.numSamples = 0;
+    options.sampleRate = UnetModelInference::sampleRate;
+    options.mono = true;
+
+    auto loop = _loader.load(file, options);
+
+    if (loop.getNumSamples() == 0)
+        return;
+
+    // The strongest hits, one per pad, in the order they come in the loop
+    auto onsets = LoopSlicer::findOnsets(loop.getReadPointer(0), loop.getNumSamples(), UnetModelInference::sampleRate);
+    auto positions = LoopSlicer::pickSlices(onsets, numSounds);
+    auto batchSize = positions.size();
+
+    if (batchSize == 0)
+        return;
+
+    std::vector<float> inputData(batchSize * sliceLength);
+    std::vector<float> outputData(batchSize * sliceLength);
+    LoopSlicer::cutSlices(loop.getReadPointer(0), loop.getNumSamples(), positions, sliceLength, inputData.data());
+
+    for (size_t b = 0; b < batchSize; b++)
+    {
+        float* slice[] = { inputData.data() + b * sliceLength };
+        juce::AudioBuffer<float> view{ slice, 1, sliceLength };
+        Utils::normalize(view);
+    }
+
+    // Every slice goes through the UNet and the classifier together
+    std::vector<size_t> classifications(batchSize);
+    std::vector<float> confidences(batchSize);
+
+    const juce::ScopedLock il(_inferenceLock);
+
+    unetModelInference.processSeededBatch(outputData.data(), inputData.data(), batchSize, _numSteps);
+
+    // Each slice is classified as it is stored
+    for (size_t b = 0; b < batchSize; b++)
+    {
+        float* slice[] = { outputData.data() + b * sliceLength };
+        juce::AudioBuffer<float> view{ slice, 1, sliceLength };
+        Utils::normalize(view);
+        view.applyGain(juce::Decibels::decibelsToGain(-3.0f));
+    }
+
+    classifierModelInference.processBatch(outputData.data(), batchSize, classifications.data(), confidences.data());
+
+    // The classifier's embeddings come one per slice, one after another
+    auto& embeddings = classifierModelInference.getEmbedding();
+    auto embeddingSize = size_t(classifierModelInference.getEmbeddingSize());
+
+    for (size_t b = 0; b < batchSize; b++)
+    {
+        juce::AudioBuffer<float> data{ UnetModelInference::numChannels, sliceLength };
+        data.copyFrom(0, 0, outputData.data() + b * sliceLength, sliceLength);
+
+        auto embedding = embeddingSize > 0 ? std::vector<float>(embeddings.begin() + std::ptrdiff_t(b * embeddingSize),
+                                                                embeddings.begin() + std::ptrdiff_t((b + 1) * embeddingSize))
+                                           : std::vector<float>();
+
+        auto d = storeGenerated(std::move(data), classifications[b], confidences[b], 0, std::move(embedding));
+        getSound(int(b))->loadDrum(d);
+    }
+}
+
+void CrasshhfyAudioProcessor::buildKitFromFolder(const juce::File& folder)
+{
+    auto files = folder.findChildFiles(juce::File::findFiles, true, _loader.getWildcardForAllFormats());
+
+    std::vector<FolderClassifier::Result> results;
+
+    {
+        const juce::ScopedLock il(_inferenceLock);
+        FolderClassifier folderClassifier{ _loader, classifierModelInference };
+        results = folderClassifier.classify(files);
+    }
+
+    // Most confident first, so each pad takes the first unused file of its type
+    std::stable_sort(results.begin(), results.end(), [](const auto& a, const auto& b) { return a.confidence > b.confidence; });
+
+    const DrumType padTypes[] = { DrumType::kick, DrumType::snare, DrumType::hat };
+    std::vector<bool> isUsed(results.size(), false);
+
+    for (int i = 0; i < numSounds; i++)
+    {
+        auto drumType = padTypes[i % 3];
+        auto best = results.size();
+
+        for (size_t r = 0; r < results.size() && best == results.size(); r++)
+            if (results[r].drumType == drumType && !isUsed[r])
+                best = r;
+
+        if (best == results.size())
+            continue;
+
+        isUsed[best] = true;
+        auto& result = results[best];
+
+        // The whole one-shot from its onset, kept in stereo at its own level
+        AudioFileLoader::Options options;
+        options.numSamples = 0;
+        options.sampleRate = UnetModelInference::sampleRate;
+        options.startAtOnset = true;
+        options.mono = false;
+
+        auto data = _loader.load(result.file, options);
+
+        if (data.getNumSamples() == 0)
+            continue;
+
+        if (data.getNumChannels() > Sound::maxNumChannels)
+            data.setSize(Sound::maxNumChannels, data.getNumSamples(), true);
+
+        Drum d;
+        d.sample = new Sample{ std::move(data), UnetModelInference::sampleRate };
+        d.drumType = result.drumType;
+        d.confidence = result.confidence;
+
+        getSound(i)->loadDrum(d);
+    }
+}
+
 void CrasshhfyAudioProcessor::inpaintSample(int soundIndex, const juce::File& file, bool half)
 {
-    auto [inputData, fs] = Utils::readWavFile(file);
+    // Starts where the file does, as the start or end is kept as it is
+    auto inputData = loadInputFile(file, false);
 
     if (inputData.getNumSamples() == 0)
         return;
 
-    inputData.setSize(UnetModelInference::numChannels, UnetModelInference::outputSize, true, true);
-
     juce::AudioBuffer<float> outputData{ UnetModelInference::numChannels, UnetModelInference::outputSize };
     size_t classification = 0;
     float confidence = 0;
 
     Utils::normalize(inputData);
 
+    const juce::ScopedLock il(_inferenceLock);
+
     unetModelInference.processSeededInpainting(outputData.getWritePointer(0), inputData.getReadPointer(0), half, _numSteps);
-    classifierModelInference.process(outputData.getReadPointer(0), &classification, &confidence);
 
     Utils::normalize(outputData);
     outputData.applyGain(juce::Decibels::decibelsToGain(-3.0f));
+    classifierModelInference.process(outputData.getReadPointer(0), &classification, &confidence);
 
-    // 0 = Kick, 1 = Hat, 2 = Snare
-    Drum d;
-    d.sample = new Sample{ std::move(outputData), UnetModelInference::sampleRate };
-    d.drumType = static_cast<DrumType>(classification + 1);
-    d.confidence = confidence;
-
+    auto d = storeGenerated(std::move(outputData), classification, confidence, 0, classifierModelInference.getEmbedding());
     getSound(soundIndex)->loadDrum(d);
 }
 
@@ -189,6 +601,47 @@ int CrasshhfyAudioProcessor::getNumSteps() const
     return _numSteps;
 }
 
+void CrasshhfyAudioProcessor::setInterpolationQuality(InterpolationQuality quality)
+{
+    // Picked up by each voice at its next note on
+    _interpolationQuality = quality;
+
+    for (auto s : _sounds)
+        s->setInterpolationQuality(quality);
+}
+
+InterpolationQuality CrasshhfyAudioProcessor::getInterpolationQuality() const
+{
+    return _interpolationQuality;
+}
+
+void CrasshhfyAudioProcessor::enableTensorDump(const juce::File& directory, std::vector<int> steps)
+{
+    _tensorDump->enable(directory, std::move(steps));
+}
+
+void CrasshhfyAudioProcessor::disableTensorDump()
+{
+    _tensorDump->disable();
+}
+
+bool CrasshhfyAudioProcessor::isTensorDumpEnabled() const
+{
+    return _tensorDump->isEnabled();
+}
+
+void CrasshhfyAudioProcessor::setChokeGroup(int soundIndex, int group)
+{
+    jassert(juce::isPositiveAndBelow(soundIndex, numSounds));
+    _synth.setChokeGroup(baseMidiNote + soundIndex, group);
+}
+
+int CrasshhfyAudioProcessor::getChokeGroup(int soundIndex) const
+{
+    jassert(juce::isPositiveAndBelow(soundIndex, numSounds));
+    return _synth.getChokeGroup(baseMidiNote + soundIndex);
+}
+
 const juce::String CrasshhfyAudioProcessor::getName() const
 {
     return JucePlugin_Name;
@@ -239,19 +692,13 @@ void CrasshhfyAudioProcessor::changeProgramName(int, const juce::String&)
 
 juce::AudioProcessorValueTreeState::ParameterLayout CrasshhfyAudioProcessor::createParameterLayout()
 {
-    std::vector<ParameterDefinition> definitions = {
-        { "Gain", "Gain", "", { 0.0f, 1.0f }, 0.5f }
-    };
+    // One group per pad, so that hosts can automate every pad
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
 
-    std::vector<std::unique_ptr<juce::AudioParameterFloat>> params;
-    for (auto& d : definitions)
-        params.push_back(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{ d.id, 1 }, 
-                                                                     d.name, 
-                                                                     d.range, 
-                                                                     d.defaultValue,
-                                                                     d.label));
+    for (int i = 0; i < numSounds; i++)
+        layout.add(SoundWithParameters::createParameterGroup(i));
 
-    return { params.begin(), params.end() };
+    return layout;
 }
 
 juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
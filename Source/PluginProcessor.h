@@ -1,7 +1,16 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "AudioFileLoader.h"
+#include "DrumLibrary.h"
+#include "DrumSynthesiser.h"
+#include "FolderClassifier.h"
+#include "LoopSlicer.h"
+#include "NoteState.h"
 #include "Sampler.h"
+#include "SampleCache.h"
+#include "SampleExporter.h"
+#include "TensorDump.h"
 #include "Utilities.h"
 #include "UnetModelInference.h"
 #include "ClassifierModelInference.h"
@@ -9,11 +18,20 @@
 class CrasshhfyAudioProcessor : public juce::AudioProcessor
 {
 public:
-    const int numSounds = 4;
-    const int numVoices = 8;
-    const int baseMidiNote = 60;
+    struct Layout
+    {
+        int numSounds = 4;
+        int numVoices = 8;
+        int maxVoicesPerPad = DrumSynthesiser::defaultMaxVoicesPerPad;
+        int baseMidiNote = 60;
+    };
 
-    CrasshhfyAudioProcessor();
+    const int numSounds;
+    const int numVoices;
+    const int baseMidiNote;
+
+    // Pads occupy consecutive notes from baseMidiNote, up to the full MIDI range
+    explicit CrasshhfyAudioProcessor(const Layout& layout = {});
     ~CrasshhfyAudioProcessor() override;
 
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -25,18 +43,52 @@ public:
 
     bool hasEditor() const override;
     juce::AudioProcessorEditor* createEditor() override;
-    juce::MidiKeyboardState& getMidiKeyboardState();
+    NoteState& getNoteState();
     DrumSound* getSound(int soundIndex);
 
-    void saveSample(int soundIndex, const juce::File& file);
+    // Message thread. Writes the pad's drum at its own rate in the background, then calls onDone there.
+    void saveSample(int soundIndex, const juce::File& file, SampleExporter::Format format, std::function<void(bool)> onDone = nullptr);
+
+    // Message thread. Writes every loaded pad into the folder in parallel, with a kit.json alongside
+    // giving each pad's file, drum type, confidence and parameter values.
+    void saveKit(const juce::File& folder, SampleExporter::Format format, std::function<void(bool)> onDone = nullptr);
 
+    // Generated drums, including drumified, sliced and varied ones, are also kept in the library
     void generateSample(int soundIndex);
+    void loadFromLibrary(int soundIndex, int entryIndex);
+    DrumLibrary& getLibrary();
+
+    // Library entries that sound most like the pad's drum, most similar first
+    juce::Array<int> findSimilarInLibrary(int soundIndex, int maxResults);
+
+    // Read from any supported format at any rate. Drumify starts at the file's first onset.
     void drumifySample(int soundIndex, const juce::File& file);
+
+    // Cuts the loop at its strongest hits and drumifies them onto the pads in order, all in one batch
+    void drumifyLoop(const juce::File& file);
+
+    // Classifies every audio file in the folder and its subfolders, then loads the most confident
+    // kick, snare and hat onto the pads in turn
+    void buildKitFromFolder(const juce::File& folder);
     void inpaintSample(int soundIndex, const juce::File& file, bool half);
+    juce::String getInputFileWildcard() const;
     
     void setNumSteps(int numSamplingSteps);
     int getNumSteps() const;
 
+    void setInterpolationQuality(InterpolationQuality quality);
+    InterpolationQuality getInterpolationQuality() const;
+
+    // Pads sharing a non-zero group cut each other off, e.g. open and closed hi-hats. Saved with the pads.
+    void setChokeGroup(int soundIndex, int group);
+    int getChokeGroup(int soundIndex) const;
+
+    // Debugging aid. Inference runs from then on write their tensors into folders in directory,
+    // at every step if steps is empty. Shared by every instance, as the models' dumps are.
+    void enableTensorDump(const juce::File& directory, std::vector<int> steps = {});
+    void disableTensorDump();
+    bool isTensorDumpEnabled() const;
+
     const juce::String getName() const override;
     bool acceptsMidi() const override;
     bool producesMidi() const override;
@@ -51,17 +103,47 @@ public:
 private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
+    juce::AudioBuffer<float> loadInputFile(const juce::File& file, bool startAtOnset);
+
+    // Keeps a generated drum in the library and returns it played from there, or from memory if it
+    // couldn't be stored. Drums not generated from noise have no seed to keep, and leave it at 0.
+    Drum storeGenerated(juce::AudioBuffer<float>&& data, size_t classification, float confidence,
+                        juce::uint32 seed, std::vector<float> embedding);
+
+    juce::ValueTree createPadState(int soundIndex);
+    void restorePads(juce::ValueTree pads, int generation);
+
     juce::AudioProcessorValueTreeState _parameters;
 
-    juce::Synthesiser _synth;
+    DrumSynthesiser _synth;
     std::vector<DrumSound*> _sounds;
     std::vector<Voice*> _voices;
 
+    AudioFileLoader _loader;
     UnetModelInference unetModelInference;
     ClassifierModelInference classifierModelInference;
+
+    // Taken around every use of the models, which keep their buffers between calls, and held on
+    // through storeGenerated where it reads the classifier's embedding
+    juce::CriticalSection _inferenceLock;
+
     int _numSteps{ 10 };
+    InterpolationQuality _interpolationQuality{ InterpolationQuality::sinc };
+
+    NoteState _noteState;
+
+    juce::SharedResourcePointer<SampleCache> _sampleCache;
+    juce::SharedResourcePointer<DrumLibrary> _library;
+    juce::SharedResourcePointer<SampleExporter> _exporter;
+    juce::SharedResourcePointer<TensorDump> _tensorDump;
+
+    // Pads from the last setStateInformation, saved as they are until they've been restored
+    juce::ValueTree _pendingPads;
+    int _stateGeneration{ 0 };
+    juce::CriticalSection _stateLock;
 
-    juce::MidiKeyboardState _midiState;
+    // Declared last so that a restore still running finishes before the sounds go away
+    juce::ThreadPool _statePool{ 1 };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CrasshhfyAudioProcessor)
 };
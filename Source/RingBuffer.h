@@ -0,0 +1,102 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Stereo ring buffer that moves whole blocks at a time.
+
+    Every operation splits into at most two contiguous runs around the wrap
+    point and hands them to FloatVectorOperations, so there is no per-sample
+    bookkeeping. Single-threaded: written and read from the audio thread.
+*/
+class StereoRingBuffer
+{
+public:
+    StereoRingBuffer() = default;
+    ~StereoRingBuffer() = default;
+
+    void prepare(int capacity)
+    {
+        jassert(capacity > 0);
+        _buffer.setSize(2, capacity);
+        clear();
+    }
+
+    void clear()
+    {
+        _readPos = 0;
+        _numReady = 0;
+    }
+
+    int getCapacity() const { return _buffer.getNumSamples(); }
+    int getNumReady() const { return _numReady; }
+    int getFreeSpace() const { return getCapacity() - _numReady; }
+
+    // Adds l/r onto the samples already waiting, appending whatever extends past them
+    void accumulate(const float* l, const float* r, int numSamples)
+    {
+        jassert(numSamples <= getCapacity());
+
+        auto numOverlap = juce::jmin(numSamples, _numReady);
+        forEachRun(_readPos, numOverlap, [&](int start, int n, int offset)
+        {
+            juce::FloatVectorOperations::add(_buffer.getWritePointer(0, start), l + offset, n);
+            juce::FloatVectorOperations::add(_buffer.getWritePointer(1, start), r + offset, n);
+        });
+
+        write(l + numOverlap, r + numOverlap, numSamples - numOverlap);
+    }
+
+    // Appends l/r after the samples already waiting
+    void write(const float* l, const float* r, int numSamples)
+    {
+        jassert(numSamples <= getFreeSpace());
+
+        forEachRun(_readPos + _numReady, numSamples, [&](int start, int n, int offset)
+        {
+            juce::FloatVectorOperations::copy(_buffer.getWritePointer(0, start), l + offset, n);
+            juce::FloatVectorOperations::copy(_buffer.getWritePointer(1, start), r + offset, n);
+        });
+
+        _numReady += numSamples;
+    }
+
+    // Mixes up to numSamples waiting samples into outL/outR and consumes them, returning the number mixed
+    int readAdd(float* outL, float* outR, int numSamples)
+    {
+        auto numToRead = juce::jmin(numSamples, _numReady);
+
+        forEachRun(_readPos, numToRead, [&](int start, int n, int offset)
+        {
+            juce::FloatVectorOperations::add(outL + offset, _buffer.getReadPointer(0, start), n);
+            juce::FloatVectorOperations::add(outR + offset, _buffer.getReadPointer(1, start), n);
+        });
+
+        _readPos = (_readPos + numToRead) % getCapacity();
+        _numReady -= numToRead;
+
+        return numToRead;
+    }
+
+private:
+    // Calls fn(bufferStart, length, offsetIntoRange) for each contiguous part of [position, position + numSamples)
+    template <typename Fn>
+    void forEachRun(int position, int numSamples, Fn&& fn)
+    {
+        auto capacity = getCapacity();
+        auto start = position % capacity;
+        auto n1 = juce::jmin(numSamples, capacity - start);
+
+        if (n1 > 0)
+            fn(start, n1, 0);
+
+        if (numSamples > n1)
+            fn(0, numSamples - n1, n1);
+    }
+
+    juce::AudioBuffer<float> _buffer;
+    int _readPos{ 0 };
+    int _numReady{ 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StereoRingBuffer)
+};
@@ -1,19 +1,235 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "PeakPyramid.h"
+#include "Utilities.h"
 
 struct Sample : public juce::ReferenceCountedObject
 {
+    // Zeros kept before and after the data, so interpolators can read past either end without bounds checks
+    static constexpr int numGuardSamples{ 32 };
+
+    // Level below which output is treated as silent, -80 dBFS
+    static constexpr float audibleThreshold{ 1.0e-4f };
+
+    // Coarse level envelope, computed once when the sample is made
+    struct Levels
+    {
+        static constexpr int blockSize{ 256 };
+
+        // RMS of each block, taking the louder channel
+        std::vector<float> rms;
+
+        // Largest absolute sample value in each block, across channels
+        std::vector<float> peak;
+
+        // Largest block peak from each block to the end, so that checking for anything audible left takes one lookup
+        std::vector<float> remainingPeak;
+
+        // One past the last sample above audibleThreshold, or 0 if the sample is silent
+        int audibleLength{ 0 };
+
+        // Fills remainingPeak in from peak
+        void updateRemainingPeak()
+        {
+            remainingPeak.resize(peak.size());
+
+            auto loudest = 0.0f;
+            for (auto b = peak.size(); b-- > 0;)
+            {
+                loudest = juce::jmax(loudest, peak[b]);
+                remainingPeak[b] = loudest;
+            }
+        }
+    };
+
     Sample(juce::AudioBuffer<float>&& sampleData, double sampleFs)
-    	: data(std::move(sampleData)), sampleRate(sampleFs) {}
+    	: padded(pad(sampleData)),
+    	  data(padded.getArrayOfWritePointers(), padded.getNumChannels(), numGuardSamples, sampleData.getNumSamples()),
+    	  sampleRate(sampleFs),
+    	  levels(analyse(data)) {}
+
+    // Holds data saved along with its hash, such as in plugin state, where the data may have been quantised
+    // since. Keeping the original hash keeps finding the variants cached for it.
+    Sample(juce::AudioBuffer<float>&& sampleData, double sampleFs, juce::int64 knownHash)
+    	: Sample(std::move(sampleData), sampleFs)
+    {
+        _hash = knownHash;
+        _hasHash = true;
+    }
+
+    // Refers to read-only channels held elsewhere, each with numGuardSamples of zeros already on
+    // either side, which stay valid for as long as storage is alive. The hash and levels are given,
+    // as worked out when the data was stored, so that none of the data has to be read here.
+    Sample(float* const* channels, int numChannels, int numSamples, double sampleFs, juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject> externalStorage,
+           juce::int64 knownHash, Levels knownLevels)
+    	: storage(std::move(externalStorage)),
+    	  data(channels, numChannels, numSamples),
+    	  sampleRate(sampleFs),
+    	  levels(std::move(knownLevels)),
+    	  _hash(knownHash),
+    	  _hasHash(true) {}
 
-    ~Sample() override = default;
+    ~Sample() override
+    {
+        delete _peaks.load();
+        delete _encoded.load();
+    }
     
+    // Owns the storage, declared first so that data can refer into it
+    juce::AudioBuffer<float> padded;
+
+    // Or keeps data held elsewhere alive, such as a memory-mapped file
+    juce::ReferenceCountedObjectPtr<juce::ReferenceCountedObject> storage;
+
     juce::AudioBuffer<float> data;
     double sampleRate;
 
+    const Levels levels;
+
+    float getRms(int position) const
+    {
+        return levels.rms.empty() ? 0.0f : levels.rms[getBlock(position)];
+    }
+
+    float getRemainingPeak(int position) const
+    {
+        return levels.remainingPeak.empty() ? 0.0f : levels.remainingPeak[getBlock(position)];
+    }
+
+    // Level envelope of the data, as a sample made from it would have
+    static Levels analyse(const juce::AudioBuffer<float>& source)
+    {
+        Levels result;
+        auto numSamples = source.getNumSamples();
+        auto numBlocks = (numSamples + Levels::blockSize - 1) / Levels::blockSize;
+
+        result.rms.resize(size_t(numBlocks));
+        result.peak.resize(size_t(numBlocks));
+
+        for (int b = 0; b < numBlocks; b++)
+        {
+            auto start = b * Levels::blockSize;
+            auto length = juce::jmin(Levels::blockSize, numSamples - start);
+
+            for (int j = 0; j < source.getNumChannels(); j++)
+            {
+                auto range = juce::FloatVectorOperations::findMinAndMax(source.getReadPointer(j, start), length);
+
+                result.rms[size_t(b)] = juce::jmax(result.rms[size_t(b)], source.getRMSLevel(j, start, length));
+                result.peak[size_t(b)] = juce::jmax(result.peak[size_t(b)], -range.getStart(), range.getEnd());
+            }
+        }
+
+        result.updateRemainingPeak();
+
+        for (int j = 0; j < source.getNumChannels(); j++)
+        {
+            auto x = source.getReadPointer(j);
+
+            for (int i = numSamples; --i >= result.audibleLength;)
+            {
+                if (std::abs(x[i]) > audibleThreshold)
+                {
+                    result.audibleLength = i + 1;
+                    break;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Identifies the sample content, stable across sessions. Hashed on first use, as only samples that
+    // are cache keys need it, rather than every resampled variant.
+    juce::int64 getHash() const
+    {
+        if (!_hasHash.load(std::memory_order_acquire))
+        {
+            // Concurrent first calls all store the same value
+            _hash.store(Utils::hashBuffer(data), std::memory_order_relaxed);
+            _hasHash.store(true, std::memory_order_release);
+        }
+
+        return _hash.load(std::memory_order_relaxed);
+    }
+
+    // The data as FLAC, for saving in plugin state. Encoded on first use and then kept, as hosts save often.
+    const juce::MemoryBlock& getEncoded() const
+    {
+        if (auto encoded = _encoded.load(std::memory_order_acquire))
+            return *encoded;
+
+        auto block = std::make_unique<juce::MemoryBlock>(Utils::encodeFlac(data, sampleRate));
+        juce::MemoryBlock* expected = nullptr;
+
+        // Only the first of any concurrent calls publishes its block
+        if (_encoded.compare_exchange_strong(expected, block.get(), std::memory_order_acq_rel))
+            return *block.release();
+
+        return *expected;
+    }
+
     using Ptr = juce::ReferenceCountedObjectPtr<Sample>;
 
+    // Waveform overview for drawing, or nullptr until preparePeaks has built it
+    const PeakPyramid* getPeaks() const
+    {
+        return _peaks.load(std::memory_order_acquire);
+    }
+
+    // Builds the peaks on pool if they aren't built yet, then calls onReady on the message thread
+    static void preparePeaks(Ptr sample, juce::ThreadPool& pool, std::function<void()> onReady)
+    {
+        if (sample->getPeaks() != nullptr)
+        {
+            if (onReady)
+                juce::MessageManager::callAsync(std::move(onReady));
+
+            return;
+        }
+
+        pool.addJob([sample, onReady = std::move(onReady)]
+        {
+            // Only the first of any concurrent requests publishes its result
+            if (sample->getPeaks() == nullptr)
+            {
+                auto peaks = std::make_unique<PeakPyramid>(sample->data);
+                PeakPyramid* expected = nullptr;
+
+                if (sample->_peaks.compare_exchange_strong(expected, peaks.get(), std::memory_order_acq_rel))
+                    peaks.release();
+            }
+
+            if (onReady)
+                juce::MessageManager::callAsync(onReady);
+        });
+    }
+
+private:
+    std::atomic<PeakPyramid*> _peaks{ nullptr };
+
+    mutable std::atomic<juce::int64> _hash{ 0 };
+    mutable std::atomic<bool> _hasHash{ false };
+
+    mutable std::atomic<juce::MemoryBlock*> _encoded{ nullptr };
+
+    static juce::AudioBuffer<float> pad(const juce::AudioBuffer<float>& source)
+    {
+        juce::AudioBuffer<float> result{ source.getNumChannels(), source.getNumSamples() + 2 * numGuardSamples };
+        result.clear();
+
+        for (int j = 0; j < source.getNumChannels(); j++)
+            result.copyFrom(j, numGuardSamples, source, j, 0, source.getNumSamples());
+
+        return result;
+    }
+
+    size_t getBlock(int position) const
+    {
+        return size_t(juce::jlimit(0, int(levels.rms.size()) - 1, position / Levels::blockSize));
+    }
+
     JUCE_DECLARE_NON_COPYABLE(Sample)
 };
 
@@ -0,0 +1,256 @@
+#include "SampleCache.h"
+
+namespace
+{
+    constexpr int diskFileMagic = 0x43525343; // "CRSC"
+    constexpr int diskFileVersion = 1;
+    const juce::String diskFileExtension{ ".smp" };
+}
+
+SampleCache::~SampleCache()
+{
+    Utils::waitForJobs(_diskWriter);
+}
+
+Sample::Ptr SampleCache::find(const Key& key)
+{
+    const juce::ScopedLock sl(_lock);
+
+    for (auto it = _entries.begin(); it != _entries.end(); ++it)
+    {
+        if (it->key == key)
+        {
+            // Move to the front so it is evicted last
+            _entries.splice(_entries.begin(), _entries, it);
+            return _entries.front().sample;
+        }
+    }
+
+    return nullptr;
+}
+
+Sample::Ptr SampleCache::findOnDisk(const Key& key)
+{
+    if (auto sample = find(key))
+        return sample;
+
+    {
+        const juce::ScopedLock sl(_lock);
+
+        if (_diskDirectory == juce::File())
+            return nullptr;
+    }
+
+    auto sample = readFromDisk(key);
+
+    if (sample != nullptr)
+    {
+        const juce::ScopedLock sl(_lock);
+        _entries.push_front({ key, sample });
+        _sizeInBytes += getSizeInBytes(*sample);
+        trim();
+    }
+
+    return sample;
+}
+
+void SampleCache::add(const Key& key, Sample::Ptr sample)
+{
+    jassert(sample != nullptr);
+
+    bool writeThrough = false;
+
+    {
+        const juce::ScopedLock sl(_lock);
+
+        for (auto& e : _entries)
+            if (e.key == key)
+                return;
+
+        _entries.push_front({ key, sample });
+        _sizeInBytes += getSizeInBytes(*sample);
+        trim();
+
+        writeThrough = _diskDirectory != juce::File();
+    }
+
+    if (writeThrough)
+    {
+        _diskWriter.addJob([this, key, sample]
+        {
+            writeToDisk(key, *sample);
+            trimDisk();
+        });
+    }
+}
+
+void SampleCache::clear()
+{
+    const juce::ScopedLock sl(_lock);
+    _entries.clear();
+    _sizeInBytes = 0;
+}
+
+void SampleCache::setMaxSizeInBytes(size_t maxSize)
+{
+    const juce::ScopedLock sl(_lock);
+    _maxSizeInBytes = maxSize;
+    trim();
+}
+
+void SampleCache::setDiskCacheDirectory(const juce::File& directory, juce::int64 maxDiskSize)
+{
+    {
+        const juce::ScopedLock sl(_lock);
+        _diskDirectory = directory;
+        _maxDiskSizeInBytes = maxDiskSize;
+    }
+
+    if (directory != juce::File())
+    {
+        directory.createDirectory();
+        trimDisk();
+    }
+}
+
+size_t SampleCache::getSizeInBytes(const Sample& sample)
+{
+    return size_t(sample.data.getNumChannels()) * size_t(sample.data.getNumSamples()) * sizeof(float);
+}
+
+void SampleCache::trim()
+{
+    // Always keep the most recent entry, even if it exceeds the limit by itself
+    while (_sizeInBytes > _maxSizeInBytes && _entries.size() > 1)
+    {
+        _sizeInBytes -= getSizeInBytes(*_entries.back().sample);
+        _entries.pop_back();
+    }
+}
+
+juce::File SampleCache::getDiskFile(const Key& key) const
+{
+    const juce::ScopedLock sl(_lock);
+
+    auto name = juce::String::toHexString(key.sourceHash)
+                + "_" + juce::String(key.sourceSampleRate, 2)
+                + "_" + juce::String(key.sampleRate, 2)
+                + "_" + juce::String(juce::roundToInt(key.fadeLength * 1e6));
+
+    return _diskDirectory.getChildFile(name + diskFileExtension);
+}
+
+Sample::Ptr SampleCache::readFromDisk(const Key& key) const
+{
+    auto file = getDiskFile(key);
+    juce::FileInputStream stream{ file };
+
+    if (!stream.openedOk())
+        return nullptr;
+
+    if (stream.readInt() != diskFileMagic || stream.readInt() != diskFileVersion)
+        return nullptr;
+
+    // The file name is lossy, so the full key is stored and checked as well
+    Key storedKey;
+    storedKey.sourceHash = stream.readInt64();
+    storedKey.sourceSampleRate = stream.readDouble();
+    storedKey.sampleRate = stream.readDouble();
+    storedKey.fadeLength = stream.readDouble();
+
+    if (!(storedKey == key))
+        return nullptr;
+
+    auto numChannels = stream.readInt();
+    auto numSamples = stream.readInt();
+
+    if (numChannels <= 0 || numSamples <= 0)
+        return nullptr;
+
+    auto numBytes = size_t(numSamples) * sizeof(float);
+    if (stream.getNumBytesRemaining() != juce::int64(numBytes) * numChannels)
+        return nullptr;
+
+    juce::AudioBuffer<float> data{ numChannels, numSamples };
+    for (int j = 0; j < numChannels; j++)
+        if (stream.read(data.getWritePointer(j), int(numBytes)) != int(numBytes))
+            return nullptr;
+
+    file.setLastAccessTime(juce::Time::getCurrentTime());
+
+    return new Sample(std::move(data), key.sampleRate);
+}
+
+void SampleCache::writeToDisk(const Key& key, const Sample& sample) const
+{
+    auto file = getDiskFile(key);
+
+    if (file.existsAsFile())
+        return;
+
+    // Written to a temporary file first so that a partial write is never picked up
+    juce::TemporaryFile temp{ file };
+
+    {
+        juce::FileOutputStream stream{ temp.getFile() };
+
+        if (!stream.openedOk())
+            return;
+
+        stream.writeInt(diskFileMagic);
+        stream.writeInt(diskFileVersion);
+        stream.writeInt64(key.sourceHash);
+        stream.writeDouble(key.sourceSampleRate);
+        stream.writeDouble(key.sampleRate);
+        stream.writeDouble(key.fadeLength);
+        stream.writeInt(sample.data.getNumChannels());
+        stream.writeInt(sample.data.getNumSamples());
+
+        auto numBytes = size_t(sample.data.getNumSamples()) * sizeof(float);
+        for (int j = 0; j < sample.data.getNumChannels(); j++)
+            stream.write(sample.data.getReadPointer(j), numBytes);
+
+        stream.flush();
+
+        if (stream.getStatus().failed())
+            return;
+    }
+
+    temp.overwriteTargetFileWithTemporary();
+}
+
+void SampleCache::trimDisk() const
+{
+    juce::File directory;
+    juce::int64 maxSize;
+
+    {
+        const juce::ScopedLock sl(_lock);
+        directory = _diskDirectory;
+        maxSize = _maxDiskSizeInBytes;
+    }
+
+    auto files = directory.findChildFiles(juce::File::findFiles, false, "*" + diskFileExtension);
+
+    juce::int64 totalSize = 0;
+    for (auto& f : files)
+        totalSize += f.getSize();
+
+    if (totalSize <= maxSize)
+        return;
+
+    // Least recently used files first
+    std::sort(files.begin(), files.end(), [](const juce::File& a, const juce::File& b)
+    {
+        return a.getLastAccessTime() < b.getLastAccessTime();
+    });
+
+    for (auto& f : files)
+    {
+        if (totalSize <= maxSize)
+            break;
+
+        totalSize -= f.getSize();
+        f.deleteFile();
+    }
+}
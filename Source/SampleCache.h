@@ -0,0 +1,68 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sample.h"
+
+class SampleCache
+{
+public:
+    struct Key
+    {
+        juce::int64 sourceHash;
+        double sourceSampleRate;
+        double sampleRate;
+        double fadeLength;
+
+        bool operator==(const Key& other) const = default;
+    };
+
+    static constexpr size_t defaultMaxSizeInBytes{ 64 * 1024 * 1024 };
+    static constexpr juce::int64 defaultMaxDiskSizeInBytes{ 512 * 1024 * 1024 };
+
+    SampleCache() = default;
+    ~SampleCache();
+
+    // Memory only, so safe to call where a disk read would hold things up, such as from prepareToPlay
+    Sample::Ptr find(const Key& key);
+
+    // Looks in memory, then reads from the disk tier, keeping what it finds in memory. Background threads only.
+    Sample::Ptr findOnDisk(const Key& key);
+
+    // Written through to the disk tier in the background
+    void add(const Key& key, Sample::Ptr sample);
+    void clear();
+
+    void setMaxSizeInBytes(size_t maxSize);
+
+    // Passing an invalid file disables the on-disk tier
+    void setDiskCacheDirectory(const juce::File& directory, juce::int64 maxDiskSize = defaultMaxDiskSizeInBytes);
+
+private:
+    struct Entry
+    {
+        Key key;
+        Sample::Ptr sample;
+    };
+
+    static size_t getSizeInBytes(const Sample& sample);
+    void trim();
+
+    juce::File getDiskFile(const Key& key) const;
+    Sample::Ptr readFromDisk(const Key& key) const;
+    void writeToDisk(const Key& key, const Sample& sample) const;
+    void trimDisk() const;
+
+    juce::CriticalSection _lock;
+
+    // Most recently used entries at the front
+    std::list<Entry> _entries;
+    size_t _sizeInBytes{ 0 };
+    size_t _maxSizeInBytes{ defaultMaxSizeInBytes };
+
+    juce::File _diskDirectory;
+    juce::int64 _maxDiskSizeInBytes{ defaultMaxDiskSizeInBytes };
+
+    juce::ThreadPool _diskWriter{ 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleCache)
+};
@@ -0,0 +1,61 @@
+#include "SampleExporter.h"
+
+SampleExporter::~SampleExporter()
+{
+    Utils::waitForJobs(_pool);
+}
+
+void SampleExporter::write(std::vector<Item> items, Format format, std::function<void(bool)> onDone)
+{
+    struct Progress
+    {
+        std::atomic<int> numPending{ 0 };
+        std::atomic<bool> hasFailed{ false };
+        std::function<void(bool)> onDone;
+    };
+
+    auto progress = std::make_shared<Progress>();
+    progress->numPending = int(items.size());
+    progress->onDone = std::move(onDone);
+
+    auto finish = [progress]
+    {
+        if (progress->onDone != nullptr)
+            juce::MessageManager::callAsync([progress] { progress->onDone(!progress->hasFailed); });
+    };
+
+    if (items.empty())
+    {
+        finish();
+        return;
+    }
+
+    auto numBits = getNumBits(format);
+
+    for (auto& item : items)
+    {
+        _pool.addJob([item = std::move(item), numBits, progress, finish]
+        {
+            auto isWritten = item.sample != nullptr
+                ? Utils::writeWavFile(item.sample->data, item.sample->sampleRate, item.file, numBits)
+                : item.file.replaceWithText(item.text);
+
+            if (!isWritten)
+                progress->hasFailed = true;
+
+            if (--progress->numPending == 0)
+                finish();
+        });
+    }
+}
+
+int SampleExporter::getNumBits(Format format)
+{
+    // WAV files at 32 bits are written as float
+    return format == Format::float32 ? 32 : 24;
+}
+
+juce::String SampleExporter::getName(Format format)
+{
+    return format == Format::float32 ? "32-bit float" : "24-bit";
+}
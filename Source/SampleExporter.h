@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sample.h"
+
+/**
+    Writes samples and their metadata to disk in the background.
+
+    Each item is written by its own job on a small pool, so a whole kit goes out
+    in parallel and the message thread is never held up by the disk. Shared by
+    every plugin instance through a SharedResourcePointer, and waits for writes
+    still in progress before it goes away.
+*/
+class SampleExporter
+{
+public:
+    enum class Format
+    {
+        int24 = 0,
+        float32
+    };
+
+    struct Item
+    {
+        juce::File file;
+
+        // Written as a WAV file, or without one, text is written instead
+        Sample::Ptr sample;
+        juce::String text;
+    };
+
+    SampleExporter() = default;
+    ~SampleExporter();
+
+    // Calls onDone on the message thread once every item has been written, with whether they all were
+    void write(std::vector<Item> items, Format format, std::function<void(bool)> onDone = nullptr);
+
+    static int getNumBits(Format format);
+    static juce::String getName(Format format);
+
+private:
+    static constexpr int maxNumThreads{ 4 };
+
+    juce::ThreadPool _pool{ juce::jmin(maxNumThreads, juce::SystemStats::getNumCpus()) };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SampleExporter)
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sample.h"
+
+/**
+    Samples published to the audio thread without locks.
+
+    Other threads publish a sample into one of numSlots slots, and the audio
+    thread reads the raw pointer and takes its own reference, but only between
+    beginBlock and endBlock. Every sample published is also held here until it
+    is safe to free: once it has been replaced, nothing else refers to it, and
+    any block that could have read it has ended. So the audio thread never
+    drops the last reference to a sample, and never reads one that is freed.
+
+    Replaced samples are freed by the next publish, or by collectGarbage, on
+    whichever thread calls them.
+*/
+template <int numSlots>
+class SampleHandoff
+{
+public:
+    SampleHandoff() = default;
+    ~SampleHandoff() = default;
+
+    // Any thread but the audio thread
+    void publish(int slot, Sample::Ptr sample)
+    {
+        jassert(juce::isPositiveAndBelow(slot, numSlots));
+
+        const juce::ScopedLock sl(_lock);
+
+        auto replaced = std::move(_held[slot]);
+        _held[slot] = sample;
+        _published[slot].store(sample.get());
+
+        // Read after the store, so a block that starts later can only see the new sample
+        if (replaced != nullptr)
+            _retired.push_back({ std::move(replaced), _blockCount.load() });
+
+        collect();
+    }
+
+    // Any thread but the audio thread
+    Sample::Ptr get(int slot) const
+    {
+        jassert(juce::isPositiveAndBelow(slot, numSlots));
+
+        const juce::ScopedLock sl(_lock);
+        return _held[slot];
+    }
+
+    // Audio thread, between beginBlock and endBlock, taking a reference before endBlock if it is kept
+    Sample* read(int slot) const
+    {
+        jassert(juce::isPositiveAndBelow(slot, numSlots));
+        return _published[slot].load();
+    }
+
+    // Audio thread. Any thread may call isPublished.
+    void beginBlock() { _blockCount++; }
+    void endBlock() { _blockCount++; }
+
+    bool isPublished(int slot) const
+    {
+        return _published[slot].load(std::memory_order_relaxed) != nullptr;
+    }
+
+    // Any thread but the audio thread
+    void collectGarbage()
+    {
+        const juce::ScopedLock sl(_lock);
+        collect();
+    }
+
+private:
+    struct Retired
+    {
+        Sample::Ptr sample;
+
+        // Odd if a block was being rendered when the sample was replaced
+        juce::uint32 blockCount;
+    };
+
+    void collect()
+    {
+        auto blockCount = _blockCount.load();
+
+        _retired.erase(std::remove_if(_retired.begin(), _retired.end(), [blockCount](const Retired& r)
+        {
+            auto blockHasEnded = (r.blockCount & 1) == 0 || r.blockCount != blockCount;
+            return blockHasEnded && r.sample->getReferenceCount() == 1;
+        }), _retired.end());
+    }
+
+    std::atomic<Sample*> _published[numSlots]{};
+
+    // Odd while the audio thread is rendering a block
+    std::atomic<juce::uint32> _blockCount{ 0 };
+
+    mutable juce::CriticalSection _lock;
+    Sample::Ptr _held[numSlots];
+    std::vector<Retired> _retired;
+
+    JUCE_DECLARE_NON_COPYABLE(SampleHandoff)
+};
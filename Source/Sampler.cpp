@@ -1,7 +1,29 @@
 #include "Sampler.h"
-#include <resample.h>
 #include "Utilities.h"
 
+Sound::~Sound()
+{
+    {
+        // Makes any queued render job skip its work
+        const juce::ScopedLock sl(_pitchedLock);
+        _pitchedGeneration++;
+    }
+
+    // Jobs refer to this sound, so wait for the one that may be running. Jobs signal while holding the
+    // lock, so once none are left, none can still be touching this sound.
+    for (;;)
+    {
+        {
+            const juce::ScopedLock sl(_pitchedLock);
+
+            if (_numPitchJobs == 0)
+                break;
+        }
+
+        _pitchJobsFinished.wait();
+    }
+}
+
 int Sound::getMidiNote() const
 {
     return _midiNote;
@@ -9,28 +31,85 @@ int Sound::getMidiNote() const
 
 void Sound::setSampleRate(double newRate)
 {
-    if (newRate != _sampleRate)
     {
+        const juce::ScopedLock sl(_sourceLock);
+
+        if (newRate == _sampleRate.load())
+            return;
+
         _sampleRate = newRate;
-        updateCurrentSample();
     }
+
+    _gain.reset(newRate, smoothingTime);
+    _pan.reset(newRate, smoothingTime);
+
+    // Called from prepareToPlay, so the disk tier is left out and a miss is resampled here
+    updateCurrentSample(false);
 }
 
 double Sound::getSampleRate() const
 {
-    return _sampleRate;
+    return _sampleRate.load();
 }
 
 void Sound::setSample(Sample::Ptr sample)
 {
-    _source = sample;
+    {
+        const juce::ScopedLock sl(_sourceLock);
+        _source = std::move(sample);
+    }
+
     updateCurrentSample();
 }
 
 Sample::Ptr Sound::getSample() const
 {   
     // Might return nullptr
-    return _current;
+    return _samples.get(currentSlot);
+}
+
+Sample::Ptr Sound::getSourceSample() const
+{
+    const juce::ScopedLock sl(_sourceLock);
+    return _source;
+}
+
+Sample* Sound::getSampleForPlayback() const
+{
+    return _samples.read(currentSlot);
+}
+
+Sample* Sound::getPitchedSampleForPlayback(double& pitchSemitones) const
+{
+    // The cache can hand back the same sample for a pitch asked for again, so the sample alone can't
+    // show whether the pitch read goes with it. If a publish overlaps the reads, the note interpolates
+    // the current sample instead, rather than waiting on the writer here.
+    auto sequence = _pitchedSequence.load();
+    auto sample = _samples.read(pitchedSlot);
+    pitchSemitones = _pitchedSemitones.load();
+
+    if ((sequence & 1) != 0 || _pitchedSequence.load() != sequence)
+        return nullptr;
+
+    return sample;
+}
+
+void Sound::publishPitched(Sample::Ptr sample, double pitchSemitones)
+{
+    _pitchedSequence++;
+    _pitchedSemitones = pitchSemitones;
+    _samples.publish(pitchedSlot, std::move(sample));
+    _pitchedSequence++;
+}
+
+void Sound::beginBlock()
+{
+    _samples.beginBlock();
+}
+
+void Sound::endBlock()
+{
+    _samples.endBlock();
 }
 
 const juce::AudioBuffer<float>& Sound::getSampleData() const
@@ -38,57 +117,79 @@ const juce::AudioBuffer<float>& Sound::getSampleData() const
     // This function should only be called when a sample is loaded
     jassert(!isEmpty());
 
-    return _current->data;
+    return _samples.read(currentSlot)->data;
 }
 
 void Sound::clearSample() 
 {
-    _prev = _current;
-    _current.reset();
-    _source.reset();
+    setSample(nullptr);
 }
 
 bool Sound::isEmpty() const
 {
-    return _current.get() == nullptr;
+    return !_samples.isPublished(currentSlot);
 }
 
 void Sound::setFadeLength(double lengthInSeconds)
 {
-    _fadeLength = lengthInSeconds;
+    {
+        const juce::ScopedLock sl(_sourceLock);
+        _fadeLength = lengthInSeconds;
+    }
+
     updateCurrentSample();
 }
 
-void Sound::setGain(double gain) 
+void Sound::setGain(float gain) 
 {
-    jassert(gain >= 0.0);
-    _gain = gain;
+    jassert(gain >= 0.0f);
+    _gain.setTargetValue(gain);
 }
 
-double Sound::getGain() const 
+float Sound::getGain() const 
 { 
-    return _gain; 
+    return _gain.getCurrentValue(); 
 }
 
-void Sound::setPan(double pan) 
+void Sound::setPan(float pan) 
 { 
-    jassert(pan >= 0.0 && pan <= 1.0); 
-    _pan = pan; 
+    jassert(pan >= 0.0f && pan <= 1.0f); 
+    _pan.setTargetValue(pan);
 }
 
-double Sound::getPan() const
+float Sound::getPan() const
 { 
-    return _pan; 
+    return _pan.getCurrentValue(); 
+}
+
+void Sound::advanceParameters(int numSamples)
+{
+    _gain.skip(numSamples);
+    _pan.skip(numSamples);
 }
 
 void Sound::setPitch(double pitch) 
 { 
-    _pitchSemitones = pitch; 
+    if (pitch != _pitchSemitones.load())
+    {
+        _pitchSemitones = pitch;
+        updatePitchedSample();
+    }
 }
 
 double Sound::getPitch() const
 {
-    return _pitchSemitones;
+    return _pitchSemitones.load();
+}
+
+void Sound::setPlaybackPitch(double pitch)
+{
+    _playbackPitchSemitones.store(pitch, std::memory_order_relaxed);
+}
+
+double Sound::getPlaybackPitch() const
+{
+    return _playbackPitchSemitones.load(std::memory_order_relaxed);
 }
 
 void Sound::setEnvelope(const juce::ADSR::Parameters& params) 
@@ -101,53 +202,185 @@ const juce::ADSR::Parameters& Sound::getEnvelope() const
     return _envelope;
 }
 
-bool Sound::appliesToNote(int midiNoteNumber)
+void Sound::setInterpolationQuality(InterpolationQuality quality)
 {
-    return midiNoteNumber == _midiNote;
+    _interpolationQuality = quality;
 }
 
-bool Sound::appliesToChannel(int)
+InterpolationQuality Sound::getInterpolationQuality() const
 {
-    return true;
+    return _interpolationQuality;
 }
 
-void Sound::updateCurrentSample()
+void Sound::updateCurrentSample(bool mayReadDisk)
 {
-    if (_source == nullptr)
+    const juce::ScopedLock ul(_updateLock);
+
+    Snapshot s;
+
     {
-        _prev = _current;
-        _current = nullptr;
-        return;
+        const juce::ScopedLock sl(_sourceLock);
+        s = { _source, _sampleRate.load(), _fadeLength };
     }
-    
-    if (!(_sampleRate > 0.0 && _source->sampleRate > 0.0))
-        return;
 
-    if (_source->data.getNumSamples() == 0)
-        return;
+    Sample::Ptr next;
 
-    auto resampled = r8b::resample(_source->data, _source->sampleRate, _sampleRate);
-    auto numSamples = resampled.getNumSamples();
+    if (s.source != nullptr)
+    {
+        if (!(s.sampleRate > 0.0 && s.source->sampleRate > 0.0))
+            return;
+
+        if (s.source->data.getNumSamples() == 0)
+            return;
+
+        next = getResampled(s.source, s.source->sampleRate, s.sampleRate, s.fadeLength, mayReadDisk);
+    }
 
-    // Apply fade
-    auto fadeLengthSamples = juce::jmin(int(_fadeLength * _sampleRate), numSamples / 2);
-    auto ptr = resampled.getArrayOfWritePointers();
-    for (int j = 0; j < resampled.getNumChannels(); j++)
     {
-        Utils::applyFade(ptr[j], 0, fadeLengthSamples, true);
-        Utils::applyFade(ptr[j], numSamples - fadeLengthSamples, fadeLengthSamples, false);
+        // The pitched sample is withdrawn first, so that no voice pairs the new sample with the old one's pitched version
+        const juce::ScopedLock sl(_pitchedLock);
+        ++_pitchedGeneration;
+        publishPitched(nullptr, 0.0);
+        _samples.publish(currentSlot, next);
+        _published = s;
+    }
+
+    updatePitchedSample();
+}
+
+Sample::Ptr Sound::getResampled(Sample::Ptr source, double sourceRate, double sampleRate, double fadeLength, bool mayReadDisk)
+{
+    // Pitched variants are keyed by the rate the source is played back as
+    SampleCache::Key key{ source->getHash(), sourceRate, sampleRate, fadeLength };
+    auto next = mayReadDisk ? _cache->findOnDisk(key) : _cache->find(key);
+
+    if (next == nullptr)
+    {
+        auto numSamples = r8b::FloatResampler::getOutputLength(source->data.getNumSamples(), sourceRate, sampleRate);
+        juce::AudioBuffer<float> resampled{ source->data.getNumChannels(), numSamples };
+
+        auto resampler = _resamplers->acquire(sourceRate, sampleRate, r8b::Quality::high, source->data.getNumChannels());
+        resampler->process(source->data, resampled);
+
+        // Apply fade
+        auto fadeLengthSamples = juce::jmin(int(fadeLength * sampleRate), numSamples / 2);
+        auto ptr = resampled.getArrayOfWritePointers();
+        for (int j = 0; j < resampled.getNumChannels(); j++)
+        {
+            Utils::applyFade(ptr[j], 0, fadeLengthSamples, true);
+            Utils::applyFade(ptr[j], numSamples - fadeLengthSamples, fadeLengthSamples, false);
+        }
+
+        next = new Sample(std::move(resampled), sampleRate);
+        _cache->add(key, next);
     }
 
-    Sample::Ptr next{ new Sample(std::move(resampled), _sampleRate) };
-    _prev = _current;
-    _current = next;
+    return next;
+}
+
+void Sound::updatePitchedSample()
+{
+    int generation;
+    double pitch;
+    Snapshot s;
+
+    {
+        // Voices fall back to interpolating the current sample until the new version is published
+        const juce::ScopedLock sl(_pitchedLock);
+        generation = ++_pitchedGeneration;
+        publishPitched(nullptr, 0.0);
+
+        pitch = _pitchSemitones.load();
+
+        if (_published.source == nullptr || pitch == 0.0)
+            return;
+
+        s = _published;
+        _numPitchJobs++;
+    }
+
+    _renderPool->addJob([this, generation, s, pitch]
+    {
+        renderPitchedSample(generation, s.source, pitch, s.sampleRate, s.fadeLength);
+
+        const juce::ScopedLock sl(_pitchedLock);
+
+        if (--_numPitchJobs == 0)
+            _pitchJobsFinished.signal();
+    });
+}
+
+void Sound::renderPitchedSample(int generation, Sample::Ptr source, double pitchSemitones, double sampleRate, double fadeLength)
+{
+    auto isCurrent = [&]
+    {
+        const juce::ScopedLock sl(_pitchedLock);
+        return generation == _pitchedGeneration;
+    };
+
+    // Skip requests that were superseded while queued
+    if (!isCurrent())
+        return;
+
+    auto ratio = std::pow(2.0, pitchSemitones / 12.0);
+    auto pitched = getResampled(source, source->sampleRate * ratio, sampleRate, fadeLength, true);
+
+    const juce::ScopedLock sl(_pitchedLock);
+
+    if (generation == _pitchedGeneration)
+    {
+        publishPitched(pitched, pitchSemitones);
+    }
 }
 
 
-SoundWithParameters::SoundWithParameters(int midiNote) 
-    : Sound(midiNote) 
+SoundWithParameters::SoundWithParameters(int midiNote, juce::AudioProcessorValueTreeState& state, int padIndex) 
+    : Sound(midiNote),
+      _state(state),
+      _pitchID(getParameterID(padIndex, kPitch))
 { 
-    initializeParameters(); 
+    for (int i = 0; i < kNumParameters; i++)
+    {
+        auto id = getParameterID(padIndex, i);
+        _parameters[i] = _state.getParameter(id);
+        _values[i] = _state.getRawParameterValue(id);
+
+        // Missing from the layout given to the state
+        jassert(_parameters[i] != nullptr && _values[i] != nullptr);
+    }
+
+    setPitch(_values[kPitch]->load());
+    setPlaybackPitch(_values[kPitch]->load());
+    _state.addParameterListener(_pitchID, this);
+}
+
+SoundWithParameters::~SoundWithParameters()
+{
+    _state.removeParameterListener(_pitchID, this);
+    cancelPendingUpdate();
+}
+
+std::unique_ptr<juce::AudioProcessorParameterGroup> SoundWithParameters::createParameterGroup(int padIndex)
+{
+    auto padName = "Pad " + juce::String(padIndex + 1);
+    auto group = std::make_unique<juce::AudioProcessorParameterGroup>("pad" + juce::String(padIndex + 1), padName, "|");
+
+    for (int i = 0; i < kNumParameters; i++)
+    {
+        auto& d = getDefinition(i);
+        group->addChild(std::make_unique<juce::AudioParameterFloat>(juce::ParameterID{ getParameterID(padIndex, i), 1 },
+                                                                    padName + " " + d.name,
+                                                                    d.range,
+                                                                    d.defaultValue,
+                                                                    d.label));
+    }
+
+    return group;
+}
+
+juce::String SoundWithParameters::getParameterID(int padIndex, int index)
+{
+    return "pad" + juce::String(padIndex + 1) + getDefinition(index).id;
 }
 
 juce::RangedAudioParameter* SoundWithParameters::getParameter(int index)
@@ -171,9 +404,25 @@ void SoundWithParameters::setSample(Sample::Ptr sample)
     }
 }
 
-void SoundWithParameters::initializeParameters()
+void SoundWithParameters::updateParameters(int numSamples)
+{
+    auto value = [this](int index) { return _values[index]->load(std::memory_order_relaxed); };
+
+    setGain(juce::Decibels::decibelsToGain(value(kGain)));
+    setPan(juce::jmap(value(kPan), -100.0f, 100.0f, 0.0f, 1.0f));
+    setEnvelope({ value(kAttack), value(kDecay), 0.01f * value(kSustain), value(kRelease) });
+
+    // Automation reaches notes from here, in step with the audio. The listener only starts the re-render.
+    setPlaybackPitch(value(kPitch));
+
+    advanceParameters(numSamples);
+}
+
+const ParameterDefinition& SoundWithParameters::getDefinition(int index)
 {
-    ParameterDefinition defs[kNumParameters] = {
+    jassert(juce::isPositiveAndBelow(index, kNumParameters));
+
+    static const ParameterDefinition defs[kNumParameters] = {
         { "Gain",       "Gain",     "dB",   { -30.0f, 30.0f },              0.0f },
         { "Pan",        "Pan",      "%",    { -100.0f, 100.0f },            0.0f },
         { "Pitch",      "Pitch",    "st",   { -12.0f, 12.0f, 1.0f },        0.0f },
@@ -183,32 +432,30 @@ void SoundWithParameters::initializeParameters()
         { "Release",    "Release",  "s",    { 0.001f, 10.0f, 0.0f, 0.25f }, 0.1f }
     };
 
-    std::function<void(float)> funcs[kNumParameters] = {
-        [this](float x) { setGain(juce::Decibels::decibelsToGain(x)); },
-        [this](float x) { setPan(juce::jmap(x, -100.0f, 100.0f, 0.0f, 1.0f)); },
-        [this](float x) { setPitch(x); },
-        [this](float x) { auto env = getEnvelope(); env.attack = x; setEnvelope(env); },
-        [this](float x) { auto env = getEnvelope(); env.decay = x; setEnvelope(env); },
-        [this](float x) { auto env = getEnvelope(); env.sustain = 0.01f * x; setEnvelope(env); },
-        [this](float x) { auto env = getEnvelope(); env.release = x; setEnvelope(env); }
-    };
+    return defs[index];
+}
 
-    for (int i = 0; i < kNumParameters; i++)
-    {
-        auto& d = defs[i];
-        auto p = new juce::AudioParameterFloat({ d.id, 1 }, d.name, d.range, d.defaultValue, d.label);
+void SoundWithParameters::parameterChanged(const juce::String&, float)
+{
+    // Can be called from the audio thread during automation. Starts re-rendering the pitched sample,
+    // which notes use once it is ready, interpolating from the unpitched sample until then.
+    triggerAsyncUpdate();
+}
 
-        _dummyProcessor.addParameter(p);
-        _parameters[i] = p;
-        _listeners.add(new ParameterListener{ *p, std::move(funcs[i]) });
-    }
+void SoundWithParameters::handleAsyncUpdate()
+{
+    setPitch(_values[kPitch]->load());
 }
 
 
 void DrumSound::loadDrum(Drum d)
 {
-    _drumType = d.drumType;
-    _confidence = d.confidence;
+    {
+        const juce::ScopedLock sl(_drumLock);
+        _drumType = d.drumType;
+        _confidence = d.confidence;
+    }
+
     setSample(d.sample);
 
     if (drumChanged)
@@ -224,99 +471,91 @@ void DrumSound::loadDrum(Drum d)
 
 DrumType DrumSound::getDrumType() const
 {
+    const juce::ScopedLock sl(_drumLock);
     return _drumType;
 }
 
 float DrumSound::getConfidence() const
 {
+    const juce::ScopedLock sl(_drumLock);
     return _confidence;
 }
 
 
 Voice::Voice()
+    : _tailScratch(2, maxTailLength)
 {
-    _fifo.prepare(2, _numFifoSamples);
+    _tail.prepare(maxTailLength);
+    _sincTable = &_sincTables->getTable(0.0);
 }
 
-bool Voice::canPlaySound(juce::SynthesiserSound* s)
+void Voice::startNote(const Sound& sound, int midiNote)
 {
-    return dynamic_cast<Sound*>(s) != nullptr;
-}
+    fadeOutToTail();
+    endNote();
 
-void Voice::startNote(int, float, juce::SynthesiserSound* sound, int)
-{
-    _sound = reinterpret_cast<Sound*>(sound);
+    // Plays the pre-pitched version at unity rate when it was rendered at the pitch in effect now
+    auto pitch = sound.getPlaybackPitch();
+    auto pitchedAt = 0.0;
+
+    Sample::Ptr sample = sound.getPitchedSampleForPlayback(pitchedAt);
+    auto isPitched = sample != nullptr && pitchedAt == pitch;
 
+    if (!isPitched)
+        sample = sound.getSampleForPlayback();
+
+    if (sample == nullptr)
+        return;
+
+    _sound = &sound;
+    _sample = std::move(sample);
+    _midiNote = midiNote;
     _noteIsOn = true;
 
-    if (!_sound->isEmpty())
-    {
-        _adsr.setSampleRate(_sound->getSampleRate());
-        _adsr.setParameters(_sound->getEnvelope());
-        _adsr.noteOn();
+    _envelope.setSampleRate(_sound->getSampleRate());
+    _envelope.setParameters(_sound->getEnvelope());
+    _envelope.noteOn();
 
-        _pitchRatio = std::pow(2.0, _sound->getPitch() / 12.0);
-        _currentIdx = 0.0;
+    _currentIdx = 0.0;
+    _interpolationQuality = _sound->getInterpolationQuality();
 
-        _gain = _sound->getGain();
-        _pan = _sound->getPan();
+    if (isPitched)
+    {
+        _pitchRatio = 1.0;
+        _sincTable = &_sincTables->getTable(0.0);
     }
+    else
+    {
+        _pitchRatio = std::pow(2.0, pitch / 12.0);
+        _sincTable = &_sincTables->getTable(pitch);
+    }
+
+    updateGains();
 }
 
-void Voice::stopNote(float, bool allowTailOff)
+void Voice::stopNote(bool allowTailOff)
 {
     if (allowTailOff)
     {
         // Note off message received
         _noteIsOn = false;
-        _adsr.noteOff();
+        _envelope.noteOff();
     }
     else
     {
-        // If the voice stops while the ADSR is active, then it was stolen and will be reused immediately
-        if (_adsr.isActive())
-        {
-            // Fill fifo with tapered output from current note, if part of the sample is still available.
-            auto& sample = _sound->getSampleData();
-            auto numSamplesRemaining = sample.getNumSamples() - 1 - int(_currentIdx);
-            auto numSamplesScaled = int(numSamplesRemaining / _pitchRatio);
-            auto length = juce::jmin(numSamplesScaled, _numFifoSamples);
+        fadeOutToTail();
+        endNote();
+    }
+}
 
-            if (length > 0)
-            {
-                for (int i = 0; i < length; i++)
-                {
-                    auto [l, r] = getNextSample();
-                    auto g = float(length - i) / float(length);
-                    l *= g;
-                    r *= g;
-
-                    // Adds any existing fifo data back in (this probably won't happen very often)
-                    if (_fifo.getNumAvailableToRead(0) > i)
-                    {
-                        l += _fifo.read(0);
-                        r += _fifo.read(1);
-                    }
-
-                    _fifo.write(0, l);
-                    _fifo.write(1, r);
-                }
-            }
-        }
-        else
-        {
-            // Empty the fifo if the voice is not going to be reused
-            while(_fifo.getNumAvailableToRead(0) > 0)
-            {
-                _fifo.read(0);
-                _fifo.read(1);
-            }
-        }
+bool Voice::isActive() const
+{
+    return _sound != nullptr || _tail.getNumReady() > 0;
+}
 
-        _adsr.reset();
-        clearCurrentNote();
-        _sound = nullptr;
-    }
+bool Voice::isPlayingNote() const
+{
+    return _sound != nullptr;
 }
 
 bool Voice::isNoteOn() const
@@ -324,80 +563,187 @@ bool Voice::isNoteOn() const
     return _noteIsOn;
 }
 
-void Voice::renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+int Voice::getMidiNote() const
+{
+    return _midiNote;
+}
+
+float Voice::getLevel() const
+{
+    if (_sound == nullptr)
+        return 0.0f;
+
+    // Scaled by how loud the sample is where it is playing, so that quiet tails are stolen first
+    return _envelope.getLevel() * juce::jmax(_gainLeft, _gainRight) * _sample->getRms(int(_currentIdx));
+}
+
+void Voice::render(float* outL, float* outR, int numSamples)
 {
+    // Play out the tail of a stolen or choked note
+    _tail.readAdd(outL, outR, numSamples);
+
     if (_sound == nullptr)
         return;
 
-    // Synth is stereo only
-    jassert(buffer.getNumChannels() == 2);
-    auto outL = buffer.getWritePointer(0, startSample);
-    auto outR = buffer.getWritePointer(1, startSample);
+    updateGains();
 
-    // Read from fifos if anything is available
-    int numSamplesFifo = juce::jmin(numSamples, _fifo.getNumAvailableToRead(0));
-    for (int i = 0; i < numSamplesFifo; i++)
-    {
-        outL[i] += _fifo.read(0);
-        outR[i] += _fifo.read(1);
-    }
+    if (_sound->isEmpty() || isInaudible() || renderSample(outL, outR, numSamples))
+        endNote();
+}
+
+void Voice::updateGains()
+{
+    auto gain = _sound->getGain();
+    auto pan = _sound->getPan();
+    _gainLeft = gain * std::cos(juce::MathConstants<float>::halfPi * pan);
+    _gainRight = gain * std::sin(juce::MathConstants<float>::halfPi * pan);
+}
+
+bool Voice::readsDirectly() const
+{
+    return _pitchRatio == 1.0 && _currentIdx == std::floor(_currentIdx);
+}
+
+int Voice::getEndIndex() const
+{
+    return juce::jmin(_sample->data.getNumSamples() - 1, _sample->levels.audibleLength);
+}
+
+bool Voice::isInaudible() const
+{
+    auto position = int(_currentIdx);
+
+    if (position >= getEndIndex())
+        return true;
+
+    auto peakGain = _envelope.getPeakLevel() * juce::jmax(_gainLeft, _gainRight);
+    return _sample->getRemainingPeak(position) * peakGain < Sample::audibleThreshold;
+}
 
-    if (_sound->isEmpty())
+void Voice::fadeOutToTail()
+{
+    if (_sound == nullptr || !_envelope.isActive())
         return;
-    
-    auto& sample = _sound->getSampleData();
-    jassert(sample.getNumChannels() == 1 || sample.getNumChannels() == 2);
 
-    for (int i = 0; i < numSamples; i++)
-    {
-        bool endOfSample = int(_currentIdx) >= sample.getNumSamples() - 1;
+    // Render a tapered tail of the current note, if part of the sample is still available
+    auto numSamplesRemaining = getEndIndex() - int(_currentIdx);
+    auto numSamplesScaled = int(numSamplesRemaining / _pitchRatio);
+    auto length = juce::jmin(numSamplesScaled, maxTailLength);
 
-        if (endOfSample || !_adsr.isActive())
-        {
-            stopNote(0.0f, false);
-            break;
-        }
+    if (length <= 0)
+        return;
 
-        // Write to output buffer
-        auto [l, r] = getNextSample();
+    _tailScratch.clear(0, length);
+    auto l = _tailScratch.getWritePointer(0);
+    auto r = _tailScratch.getWritePointer(1);
 
-        outL[i] += l;
-        outR[i] += r;
-    }
+    renderSample(l, r, length);
+    applyTaper(l, r, length);
+
+    // Mixed onto any tail still playing out (this probably won't happen very often)
+    _tail.accumulate(l, r, length);
+}
+
+void Voice::endNote()
+{
+    _envelope.reset();
+    _noteIsOn = false;
+    _midiNote = -1;
+    _sound = nullptr;
+
+    // Never the last reference, as the sound holds every sample it has published until no voice refers to it
+    _sample = nullptr;
+}
+
+bool Voice::renderSample(float* outL, float* outR, int numSamples)
+{
+    auto& sample = _sample->data;
+    jassert(sample.getNumChannels() == 1 || sample.getNumChannels() == 2);
+
+    if (sample.getNumChannels() > 1)
+        return renderSample<2>(sample, outL, outR, numSamples);
+
+    return renderSample<1>(sample, outL, outR, numSamples);
 }
 
-Voice::StereoSample Voice::readFromSample(const juce::AudioBuffer<float>& data, float fractionalIndex)
+template <int numChannels>
+bool Voice::renderSample(const juce::AudioBuffer<float>& sample, float* outL, float* outR, int numSamples)
 {
-    auto idx0 = int(fractionalIndex);
-    auto idx1 = idx0 + 1;
+    const float* in[numChannels];
+    for (int j = 0; j < numChannels; j++)
+        in[j] = sample.getReadPointer(j);
+
+    // Output samples left before the read position reaches the last sample
+    auto numRemaining = juce::jmax(0, int(std::ceil((getEndIndex() - _currentIdx) / _pitchRatio)));
 
-    // Sample index must be in range
-    jassert(idx1 < data.getNumSamples());
+    float interpolated[numChannels][renderChunkSize];
+    float envelope[renderChunkSize];
+    int i = 0;
+
+    while (i < numSamples)
+    {
+        auto numToRender = juce::jmin(numSamples - i, numRemaining, renderChunkSize);
 
-    auto g1 = fractionalIndex - float(idx0);
-    auto g0 = 1.0f - g1;
+        // Stops short if the envelope finishes within this chunk
+        if (numToRender > 0)
+            numToRender = _envelope.render(envelope, numToRender);
 
-    auto inL = data.getReadPointer(0);
-    auto inR = data.getNumChannels() > 1 ? data.getReadPointer(1) : nullptr;
+        if (numToRender <= 0)
+            return true;
 
-    auto l = g0 * inL[idx0] + g1 * inL[idx1];
-    auto r = inR == nullptr ? l : g0 * inR[idx0] + g1 * inR[idx1];
+        const float* chunk[numChannels];
 
-    return { l, r };
+        if (readsDirectly())
+        {
+            for (int j = 0; j < numChannels; j++)
+                chunk[j] = in[j] + int(_currentIdx);
+
+            _currentIdx += numToRender;
+        }
+        else
+        {
+            // Guard samples make the last few reads safe even if rounding overshoots by one
+            auto position = _currentIdx;
+
+            for (int j = 0; j < numChannels; j++)
+            {
+                _currentIdx = Interpolator::process(_interpolationQuality, *_sincTable, in[j], position, _pitchRatio, interpolated[j], numToRender);
+                chunk[j] = interpolated[j];
+            }
+        }
+
+        mix<numChannels>(chunk, envelope, _gainLeft, _gainRight, outL + i, outR + i, numToRender);
+
+        i += numToRender;
+        numRemaining -= numToRender;
+    }
+
+    return false;
 }
 
-Voice::StereoSample Voice::getNextSample()
+template <int numChannels>
+void Voice::mix(const float* const* in, const float* envelope, float gainLeft, float gainRight, float* outL, float* outR, int numSamples)
 {
-    jassert(_sound != nullptr && !_sound->isEmpty());
+    // Mono samples feed both sides
+    auto inL = in[0];
+    auto inR = in[numChannels - 1];
 
-    // Get current sample output and increment index & ADSR
-    auto g = _adsr.getNextSample() * _gain;
-    auto [l, r] = readFromSample(_sound->getSampleData(), float(_currentIdx));
-    _currentIdx += _pitchRatio;
+    for (int i = 0; i < numSamples; i++)
+    {
+        outL[i] += inL[i] * envelope[i] * gainLeft;
+        outR[i] += inR[i] * envelope[i] * gainRight;
+    }
+}
 
-    // Apply pan
-    auto panLeft = juce::dsp::FastMathApproximations::cos(juce::MathConstants<float>::halfPi * _pan);
-    auto panRight = juce::dsp::FastMathApproximations::sin(juce::MathConstants<float>::halfPi * _pan);
+void Voice::applyTaper(float* l, float* r, int numSamples)
+{
+    // Linear fade to zero over the whole tail
+    auto scale = 1.0f / float(numSamples);
 
-    return { l * g * panLeft, r * g * panRight };
+    for (int i = 0; i < numSamples; i++)
+    {
+        auto g = float(numSamples - i) * scale;
+        l[i] *= g;
+        r[i] *= g;
+    }
 }
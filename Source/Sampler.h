@@ -1,17 +1,22 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "Fifo.h"
+#include "Envelope.h"
+#include "Interpolator.h"
+#include "RingBuffer.h"
 #include "Sample.h"
+#include "SampleCache.h"
+#include "SampleHandoff.h"
+#include <resample.h>
 #include "Utilities.h"
 
-class Sound : public juce::SynthesiserSound
+class Sound
 {
 public:
     static constexpr int maxNumChannels{ 2 };
 
     Sound(int midiNote) : _midiNote(midiNote) {}
-    ~Sound() override = default;
+    virtual ~Sound();
 
     int getMidiNote() const;
 
@@ -19,47 +24,125 @@ public:
     double getSampleRate() const;
 
     virtual void setSample(Sample::Ptr sample);
+
+    // Any thread but the audio thread
     Sample::Ptr getSample() const;
+
+    // As given to setSample, before conversion to the playback rate
+    Sample::Ptr getSourceSample() const;
+
+    // Audio thread, between beginBlock and endBlock, for voices to take their own reference to.
+    // The pitched sample is the sample pre-rendered at pitchSemitones, or nullptr while none is ready.
+    Sample* getSampleForPlayback() const;
+    Sample* getPitchedSampleForPlayback(double& pitchSemitones) const;
+
+    // Audio thread, around rendering each block, so that replaced samples are only freed once no voice can be reading them
+    void beginBlock();
+    void endBlock();
+
     const juce::AudioBuffer<float>& getSampleData() const;
     void clearSample();
     bool isEmpty() const;
     void setFadeLength(double lengthInSeconds);
 
-    void setGain(double gain);
-    double getGain() const;
+    // Gain and pan glide to new values over smoothingTime, moved on a block at a time by advanceParameters
+    void setGain(float gain);
+    float getGain() const;
 
-    void setPan(double pan);
-    double getPan() const;
+    void setPan(float pan);
+    float getPan() const;
 
+    void advanceParameters(int numSamples);
+
+    // Message thread, as it starts re-rendering the pitched sample
     void setPitch(double pitch);
     double getPitch() const;
 
+    // Audio thread. The pitch notes start at, which uses the pitched sample only if it was rendered at the same pitch.
+    void setPlaybackPitch(double pitch);
+    double getPlaybackPitch() const;
+
     void setEnvelope(const juce::ADSR::Parameters& params);
     const juce::ADSR::Parameters& getEnvelope() const;
 
-    bool appliesToNote(int midiNoteNumber) override;
-    bool appliesToChannel(int midiChannel) override;
+    void setInterpolationQuality(InterpolationQuality quality);
+    InterpolationQuality getInterpolationQuality() const;
 
 private:
-    void updateCurrentSample();
+    // The disk tier of the cache is only read where mayReadDisk is set
+    void updateCurrentSample(bool mayReadDisk = true);
+    Sample::Ptr getResampled(Sample::Ptr source, double sourceRate, double sampleRate, double fadeLength, bool mayReadDisk);
+
+    void updatePitchedSample();
+    void renderPitchedSample(int generation, Sample::Ptr source, double pitchSemitones, double sampleRate, double fadeLength);
+
+    // What a sample is made from, taken together so that one update never mixes two loads
+    struct Snapshot
+    {
+        Sample::Ptr source;
+        double sampleRate{ 0.0 };
+        double fadeLength{ 0.0 };
+    };
 
     const int _midiNote;
-    double _sampleRate{ 0.0 };
-    double _sourceSampleRate{ 0.0 };
 
-    double _gain{ 1.0f };
-    double _pan{ 0.5f };
-    double _pitchSemitones{ 0.0f };
-    juce::ADSR::Parameters _envelope{ 0.002f, 0.1f, 1.0f, 1.0f };
+    // Written under _sourceLock, and atomic as voices read it on the audio thread
+    std::atomic<double> _sampleRate{ 0.0 };
 
-    Sample::Ptr _source, _current, _prev;
+    static constexpr double smoothingTime{ 0.02 };
 
+    juce::SmoothedValue<float> _gain{ 1.0f };
+    juce::SmoothedValue<float> _pan{ 0.5f };
+    std::atomic<double> _pitchSemitones{ 0.0 };
+    std::atomic<double> _playbackPitchSemitones{ 0.0 };
+    juce::ADSR::Parameters _envelope{ 0.002f, 0.1f, 1.0f, 1.0f };
+    std::atomic<InterpolationQuality> _interpolationQuality{ InterpolationQuality::sinc };
+
+    // Loads come from worker threads while the message thread reads, so these are only touched under the lock
+    mutable juce::CriticalSection _sourceLock;
+    Sample::Ptr _source;
     double _fadeLength{ 3e-3 };
 
+    // Held for the whole of updateCurrentSample, so that concurrent loads publish in the order they take their snapshots
+    juce::CriticalSection _updateLock;
+
+    // The current sample at the playback rate and, rendered in the background whenever the pitch or the
+    // current sample changes, its pitched version
+    static constexpr int currentSlot{ 0 };
+    static constexpr int pitchedSlot{ 1 };
+    SampleHandoff<2> _samples;
+
+    // Under _pitchedLock. Publishes the pitched sample together with the pitch it was rendered at.
+    void publishPitched(Sample::Ptr sample, double pitchSemitones);
+
+    // The pitched sample's pitch, and a count that is odd while either is being changed, so the
+    // audio thread can tell when it has read a sample and a pitch that belong together
+    std::atomic<double> _pitchedSemitones{ 0.0 };
+    std::atomic<juce::uint32> _pitchedSequence{ 0 };
+
+    juce::CriticalSection _pitchedLock;
+    int _pitchedGeneration{ 0 };
+
+    // What the current sample was made from, under _pitchedLock, so its pitched version is made from the same
+    Snapshot _published;
+
+    // Render jobs refer to this sound, so it waits for them to finish before it goes away
+    int _numPitchJobs{ 0 };
+    juce::WaitableEvent _pitchJobsFinished;
+    juce::SharedResourcePointer<juce::ThreadPool> _renderPool;
+
+    // Resampled variants shared by every Sound in the process
+    juce::SharedResourcePointer<SampleCache> _cache;
+
+    // Keeps built resamplers alive between conversions
+    juce::SharedResourcePointer<r8b::ResamplerPool> _resamplers;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Sound)
 };
 
-class SoundWithParameters : public Sound
+class SoundWithParameters : public Sound,
+                            private juce::AudioProcessorValueTreeState::Listener,
+                            private juce::AsyncUpdater
 {
 public:
     enum Parameters
@@ -74,20 +157,32 @@ public:
         kNumParameters
     };
 
-    SoundWithParameters(int midiNote);
-    ~SoundWithParameters() override = default;
+    // The parameters must already be in state, from createParameterGroup with the same padIndex
+    SoundWithParameters(int midiNote, juce::AudioProcessorValueTreeState& state, int padIndex);
+    ~SoundWithParameters() override;
+
+    static std::unique_ptr<juce::AudioProcessorParameterGroup> createParameterGroup(int padIndex);
+    static juce::String getParameterID(int padIndex, int index);
+    static const ParameterDefinition& getDefinition(int index);
 
     juce::RangedAudioParameter* getParameter(int index);
     void setSample(Sample::Ptr sample) override;
 
+    // Audio thread: takes the latest parameter values and moves smoothing on by a block
+    void updateParameters(int numSamples);
+
     std::function<void()> sampleChanged = nullptr;
 
 private:
-    void initializeParameters();
+    // Pitch changes are passed on from the message thread
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+
+    juce::AudioProcessorValueTreeState& _state;
+    const juce::String _pitchID;
 
-    DummyProcessor _dummyProcessor;
     juce::RangedAudioParameter* _parameters[kNumParameters];
-    juce::OwnedArray<ParameterListener> _listeners;
+    std::atomic<float>* _values[kNumParameters];
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SoundWithParameters)
 };
@@ -95,7 +190,8 @@ private:
 class DrumSound : public SoundWithParameters
 {
 public:
-    DrumSound(int midiNote) : SoundWithParameters(midiNote) {}
+    DrumSound(int midiNote, juce::AudioProcessorValueTreeState& state, int padIndex)
+        : SoundWithParameters(midiNote, state, padIndex) {}
     ~DrumSound() override = default;
 
     std::function<void()> drumChanged = nullptr;
@@ -105,46 +201,90 @@ public:
     float getConfidence() const;
 
 private:
+    // Set by loads on worker threads and read on the message thread
+    mutable juce::CriticalSection _drumLock;
     DrumType _drumType{ DrumType::none };
     float _confidence{ 0.0f };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DrumSound)
 };
 
-class Voice : public juce::SynthesiserVoice
+class Voice
 {
 public:
     Voice();
-    ~Voice() override = default;
+    ~Voice() = default;
+
+    // A note that is still playing is faded out over a short tail while the new one starts
+    void startNote(const Sound& sound, int midiNote);
 
-    bool canPlaySound(juce::SynthesiserSound* s) override;
+    // Releases the note, or without tail-off fades it out over a short tail
+    void stopNote(bool allowTailOff);
 
-    void startNote(int, float velocity, juce::SynthesiserSound* sound, int) override;
-    void stopNote(float velocity, bool allowTailOff) override;
+    // True while the voice produces output, either from a note or from a faded-out tail
+    bool isActive() const;
+    bool isPlayingNote() const;
     bool isNoteOn() const;
+    int getMidiNote() const;
 
-    void renderNextBlock(juce::AudioBuffer<float>& buffer, int startSample, int numSamples) override;
+    // Envelope level scaled by the louder side's gain, used to pick a voice to steal
+    float getLevel() const;
 
-    void pitchWheelMoved(int) override {}
-    void controllerMoved(int, int) override {}
+    // Adds the next numSamples of output to outL/outR, following the sound's gain and pan
+    void render(float* outL, float* outR, int numSamples);
 
 private:
-    typedef std::array<float, 2> StereoSample;
-    static StereoSample readFromSample(const juce::AudioBuffer<float>& data, float fractionalIndex);
-    StereoSample getNextSample();
+    // Output samples rendered per pass in render
+    static constexpr int renderChunkSize{ 64 };
+
+    // Returns true once the note has finished
+    bool renderSample(float* outL, float* outR, int numSamples);
+
+    template <int numChannels>
+    bool renderSample(const juce::AudioBuffer<float>& sample, float* outL, float* outR, int numSamples);
+
+    template <int numChannels>
+    static void mix(const float* const* in, const float* envelope, float gainLeft, float gainRight, float* outL, float* outR, int numSamples);
+
+    static void applyTaper(float* l, float* r, int numSamples);
+
+    // True at unity rate on a whole-sample position, where output is read straight from the sample
+    bool readsDirectly() const;
+
+    // Read position at which the note ends, past which the sample is silent
+    int getEndIndex() const;
+
+    // True once no sample left, at the envelope's remaining peak and the gain, is above the audible threshold
+    bool isInaudible() const;
+
+    void updateGains();
+    void fadeOutToTail();
+    void endNote();
     
-    juce::ADSR _adsr;
+    Envelope _envelope;
     bool _noteIsOn{ false };
+    int _midiNote{ -1 };
 
     const Sound* _sound{ nullptr };
+    Sample::Ptr _sample;
     double _pitchRatio{ 1.0 };
     double _currentIdx{ 0.0 };
 
-    float _gain{ 1.0f };
-    float _pan{ 0.5f };
+    InterpolationQuality _interpolationQuality{ InterpolationQuality::sinc };
+    juce::SharedResourcePointer<SincTableSet> _sincTables;
+    const SincTable* _sincTable{ nullptr };
+
+    // Gain and pan law, updated from the sound once per block
+    float _gainLeft{ 1.0f };
+    float _gainRight{ 1.0f };
+
+    // Tapered tail of a stolen or choked note, played out alongside the voice's next note
+    static constexpr int maxTailLength{ 512 };
+    StereoRingBuffer _tail;
+    juce::AudioBuffer<float> _tailScratch;
 
-    const int _numFifoSamples{ 512 };
-    Fifo _fifo;
+    // Renders voices that read directly several at a time, straight from their playback state
+    friend class VoiceLanes;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Voice)
 };
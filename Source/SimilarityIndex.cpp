@@ -0,0 +1,220 @@
+#include "SimilarityIndex.h"
+
+SimilarityIndex::SimilarityIndex(int dimension)
+{
+    reset(dimension);
+}
+
+void SimilarityIndex::reset(int dimension)
+{
+    jassert(dimension >= 0);
+
+    _dimension = dimension;
+    _stride = (dimension + numAccumulators - 1) / numAccumulators * numAccumulators;
+
+    _vectors.clear();
+    _ids.clear();
+    _centroids.clear();
+    _lists.clear();
+    _numTrained = 0;
+
+    _query.assign(size_t(_stride), 0.0f);
+}
+
+int SimilarityIndex::getDimension() const
+{
+    return _dimension;
+}
+
+int SimilarityIndex::size() const
+{
+    return int(_ids.size());
+}
+
+void SimilarityIndex::add(int id, const float* vector)
+{
+    auto row = size();
+    _vectors.resize(_vectors.size() + size_t(_stride), 0.0f);
+
+    if (!normalise(vector, _vectors.data() + size_t(row) * size_t(_stride)))
+    {
+        _vectors.resize(size_t(row) * size_t(_stride));
+        return;
+    }
+
+    _ids.push_back(id);
+
+    // Filed with the current clustering until the next one
+    if (!_lists.empty())
+        _lists[size_t(findNearestCentroid(getRow(row)))].push_back(row);
+}
+
+std::vector<SimilarityIndex::Match> SimilarityIndex::findNearest(const float* query, int maxResults, int excludedId)
+{
+    _candidates.clear();
+
+    if (maxResults <= 0 || _ids.empty() || !normalise(query, _query.data()))
+        return {};
+
+    if (size() < maxBruteForceSize)
+    {
+        _centroids.clear();
+        _lists.clear();
+        _numTrained = 0;
+    }
+    else if (size() >= 2 * _numTrained)
+    {
+        train();
+    }
+
+    if (_lists.empty())
+    {
+        for (int row = 0; row < size(); row++)
+            if (_ids[size_t(row)] != excludedId)
+                _candidates.push_back({ _ids[size_t(row)], dot(_query.data(), getRow(row)) });
+    }
+    else
+    {
+        // Probes the lists whose centroids are closest to the query
+        std::vector<Match> lists;
+        lists.reserve(_lists.size());
+
+        for (size_t l = 0; l < _lists.size(); l++)
+            lists.push_back({ int(l), dot(_query.data(), _centroids.data() + l * size_t(_stride)) });
+
+        auto probes = std::min(lists.size(), size_t(numProbes));
+        std::partial_sort(lists.begin(), lists.begin() + std::ptrdiff_t(probes), lists.end(),
+                          [](const Match& a, const Match& b) { return a.similarity > b.similarity; });
+
+        for (size_t p = 0; p < probes; p++)
+            scoreRows(_lists[size_t(lists[p].id)], excludedId);
+    }
+
+    auto numResults = std::min(_candidates.size(), size_t(maxResults));
+    std::partial_sort(_candidates.begin(), _candidates.begin() + std::ptrdiff_t(numResults), _candidates.end(),
+                      [](const Match& a, const Match& b) { return a.similarity > b.similarity; });
+
+    return { _candidates.begin(), _candidates.begin() + std::ptrdiff_t(numResults) };
+}
+
+float SimilarityIndex::dot(const float* a, const float* b) const
+{
+    // Independent partial sums, so the compiler can keep them in one vector register
+    float sums[numAccumulators] = {};
+
+    for (int i = 0; i < _stride; i += numAccumulators)
+        for (int j = 0; j < numAccumulators; j++)
+            sums[j] += a[i + j] * b[i + j];
+
+    float result = 0.0f;
+
+    for (auto s : sums)
+        result += s;
+
+    return result;
+}
+
+const float* SimilarityIndex::getRow(int row) const
+{
+    return _vectors.data() + size_t(row) * size_t(_stride);
+}
+
+bool SimilarityIndex::normalise(const float* source, float* dest) const
+{
+    double sumOfSquares = 0.0;
+
+    for (int i = 0; i < _dimension; i++)
+        sumOfSquares += double(source[i]) * double(source[i]);
+
+    if (sumOfSquares <= 0.0 || !std::isfinite(sumOfSquares))
+        return false;
+
+    auto scale = float(1.0 / std::sqrt(sumOfSquares));
+
+    for (int i = 0; i < _dimension; i++)
+        dest[i] = source[i] * scale;
+
+    // Padding stays zero so it adds nothing to dot products
+    std::fill(dest + _dimension, dest + _stride, 0.0f);
+
+    return true;
+}
+
+int SimilarityIndex::findNearestCentroid(const float* vector) const
+{
+    auto numLists = int(_centroids.size() / size_t(_stride));
+    int best = 0;
+    auto bestSimilarity = -std::numeric_limits<float>::max();
+
+    for (int l = 0; l < numLists; l++)
+    {
+        auto similarity = dot(vector, _centroids.data() + size_t(l) * size_t(_stride));
+
+        if (similarity > bestSimilarity)
+        {
+            best = l;
+            bestSimilarity = similarity;
+        }
+    }
+
+    return best;
+}
+
+void SimilarityIndex::train()
+{
+    auto numRows = size();
+    auto numLists = juce::jmax(1, int(std::sqrt(double(numRows))));
+
+    // Spherical k-means on an evenly spread subset, seeded with evenly spread rows
+    auto numTrainingRows = juce::jmin(numRows, numLists * maxTrainingRowsPerList);
+    auto trainingRows = std::vector<int>(size_t(numTrainingRows));
+
+    for (int i = 0; i < numTrainingRows; i++)
+        trainingRows[size_t(i)] = int(juce::int64(i) * numRows / numTrainingRows);
+
+    _centroids.assign(size_t(numLists) * size_t(_stride), 0.0f);
+
+    for (int l = 0; l < numLists; l++)
+        std::copy_n(getRow(trainingRows[size_t(l * numTrainingRows / numLists)]), _stride,
+                    _centroids.begin() + std::ptrdiff_t(l) * _stride);
+
+    std::vector<float> sums(_centroids.size());
+    auto counts = std::vector<int>(size_t(numLists));
+
+    for (int iteration = 0; iteration < numTrainingIterations; iteration++)
+    {
+        std::fill(sums.begin(), sums.end(), 0.0f);
+        std::fill(counts.begin(), counts.end(), 0);
+
+        for (auto row : trainingRows)
+        {
+            auto l = size_t(findNearestCentroid(getRow(row)));
+            auto sum = sums.data() + l * size_t(_stride);
+            auto v = getRow(row);
+
+            for (int i = 0; i < _stride; i++)
+                sum[i] += v[i];
+
+            counts[l]++;
+        }
+
+        // An empty list keeps its previous centroid
+        for (size_t l = 0; l < size_t(numLists); l++)
+            if (counts[l] > 0)
+                normalise(sums.data() + l * size_t(_stride), _centroids.data() + l * size_t(_stride));
+    }
+
+    _lists.assign(size_t(numLists), {});
+
+    for (int row = 0; row < numRows; row++)
+        _lists[size_t(findNearestCentroid(getRow(row)))].push_back(row);
+
+    _numTrained = numRows;
+}
+
+void SimilarityIndex::scoreRows(const std::vector<int>& rows, int excludedId)
+{
+    for (auto row : rows)
+        if (_ids[size_t(row)] != excludedId)
+            _candidates.push_back({ _ids[size_t(row)], dot(_query.data(), getRow(row)) });
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Nearest-neighbour search over embedding vectors by cosine similarity.
+
+    Vectors are normalised when added, so similarity is a dot product, and
+    stored contiguously with the dimension padded to a whole number of
+    accumulators so that the dot product loop vectorises without a tail.
+
+    Small sets are searched exhaustively. Once there are maxBruteForceSize
+    vectors the index clusters them with k-means into about sqrt(n) lists
+    (an inverted file), and a search only scores the vectors in the lists
+    whose centroids are closest to the query. The clustering is redone
+    whenever the set has doubled since it was last made, the first search
+    after that pays for it.
+
+    Not thread safe, callers lock around it.
+*/
+class SimilarityIndex
+{
+public:
+    struct Match
+    {
+        int id{ -1 };
+        float similarity{ 0.0f };
+    };
+
+    static constexpr int maxBruteForceSize{ 4096 };
+
+    explicit SimilarityIndex(int dimension = 0);
+    ~SimilarityIndex() = default;
+
+    // Removes every vector and sets the dimension of those added afterwards
+    void reset(int dimension);
+
+    int getDimension() const;
+    int size() const;
+
+    // Zero vectors have no direction, so are ignored
+    void add(int id, const float* vector);
+
+    // Most similar first, leaving out excludedId
+    std::vector<Match> findNearest(const float* query, int maxResults, int excludedId = -1);
+
+private:
+    // Partial sums kept by the dot product, which the stored dimension is padded to
+    static constexpr int numAccumulators{ 8 };
+
+    static constexpr int numProbes{ 8 };
+    static constexpr int numTrainingIterations{ 8 };
+    static constexpr int maxTrainingRowsPerList{ 32 };
+
+    float dot(const float* a, const float* b) const;
+    const float* getRow(int row) const;
+    bool normalise(const float* source, float* dest) const;
+
+    int findNearestCentroid(const float* vector) const;
+    void train();
+    void scoreRows(const std::vector<int>& rows, int excludedId);
+
+    int _dimension{ 0 };
+    int _stride{ 0 };
+
+    std::vector<float> _vectors;
+    std::vector<int> _ids;
+
+    // Inverted file, empty while the set is searched exhaustively
+    std::vector<float> _centroids;
+    std::vector<std::vector<int>> _lists;
+    int _numTrained{ 0 };
+
+    std::vector<float> _query;
+    std::vector<Match> _candidates;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SimilarityIndex)
+};
@@ -0,0 +1,142 @@
+#include "TensorDump.h"
+
+TensorDump::Run::Run(TensorDump& owner, const juce::File& folder, std::vector<int> steps)
+    : _owner(owner),
+      _folder(folder),
+      _steps(std::move(steps))
+{
+}
+
+TensorDump::Run::~Run()
+{
+    if (_tensors.empty())
+        return;
+
+    _owner._writer.addJob([folder = _folder, tensors = std::make_shared<std::vector<Tensor>>(std::move(_tensors))]
+    {
+        folder.createDirectory();
+
+        for (auto& t : *tensors)
+            writeNpy(t.file, t.data.data(), t.shape);
+    });
+}
+
+bool TensorDump::Run::wantsStep(int step) const
+{
+    return _steps.empty() || std::find(_steps.begin(), _steps.end(), step) != _steps.end();
+}
+
+void TensorDump::Run::capture(int step, const juce::String& name, const float* data, std::vector<size_t> shape)
+{
+    if (!wantsStep(step))
+        return;
+
+    auto size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+
+    Tensor t;
+    t.file = _folder.getChildFile(juce::String::formatted("step%02d_", step) + name + ".npy");
+    t.data.assign(data, data + size);
+    t.shape = std::move(shape);
+    _tensors.push_back(std::move(t));
+}
+
+TensorDump::TensorDump()
+{
+    auto directory = juce::SystemStats::getEnvironmentVariable("CRASHHFY_TENSOR_DUMP", {});
+
+    if (directory.isEmpty() || !juce::File::isAbsolutePath(directory))
+        return;
+
+    std::vector<int> steps;
+    auto stepList = juce::StringArray::fromTokens(juce::SystemStats::getEnvironmentVariable("CRASHHFY_TENSOR_DUMP_STEPS", {}), ",", {});
+    stepList.removeEmptyStrings();
+
+    for (auto& s : stepList)
+        steps.push_back(s.trim().getIntValue());
+
+    enable(juce::File{ directory }, std::move(steps));
+}
+
+TensorDump::~TensorDump()
+{
+    Utils::waitForJobs(_writer);
+}
+
+void TensorDump::enable(const juce::File& directory, std::vector<int> steps)
+{
+    const juce::ScopedLock sl(_lock);
+    _directory = directory;
+    _steps = std::move(steps);
+    _isEnabled = true;
+}
+
+void TensorDump::disable()
+{
+    // Taken so that a run beginning under the lock sees the directory and flag change together
+    const juce::ScopedLock sl(_lock);
+    _isEnabled = false;
+}
+
+bool TensorDump::isEnabled() const
+{
+    return _isEnabled;
+}
+
+std::unique_ptr<TensorDump::Run> TensorDump::beginRun()
+{
+    if (!_isEnabled.load(std::memory_order_relaxed))
+        return nullptr;
+
+    const juce::ScopedLock sl(_lock);
+
+    // Checked again, as it may have been disabled since
+    if (!_isEnabled)
+        return nullptr;
+
+    // Numbered from the time, so runs from separate sessions in the same directory don't overwrite each other
+    auto name = juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S-") + juce::String(++_numRuns).paddedLeft('0', 4);
+    return std::make_unique<Run>(*this, _directory.getChildFile(name), _steps);
+}
+
+bool TensorDump::writeNpy(const juce::File& file, const float* data, const std::vector<size_t>& shape)
+{
+    auto size = std::accumulate(shape.begin(), shape.end(), size_t(1), std::multiplies<size_t>());
+
+    juce::String shapeText;
+
+    for (auto n : shape)
+        shapeText << juce::String(juce::int64(n)) << ", ";
+
+    // One-element shapes keep their trailing comma, as Python tuples need it
+    if (shape.size() > 1)
+        shapeText = shapeText.trimEnd().dropLastCharacters(1);
+
+    auto header = "{'descr': '<f4', 'fortran_order': False, 'shape': (" + shapeText + "), }";
+
+    // The magic, version and header length take 10 bytes, and the header is padded so the data starts 64-byte aligned
+    static constexpr int preambleSize = 10;
+    auto headerSize = (preambleSize + header.length() + 1 + 63) / 64 * 64 - preambleSize;
+    header = header.paddedRight(' ', headerSize - 1) + "\n";
+
+    // The data is large enough to go straight to the file in one write
+    file.deleteFile();
+    juce::FileOutputStream stream{ file, 1 << 16 };
+
+    if (!stream.openedOk())
+        return false;
+
+    static const char magic[] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+    stream.write(magic, sizeof(magic));
+    stream.writeShort(short(headerSize));
+    stream.write(header.toRawUTF8(), size_t(headerSize));
+
+   #if JUCE_LITTLE_ENDIAN
+    stream.write(data, size * sizeof(float));
+   #else
+    for (size_t i = 0; i < size; i++)
+        stream.writeFloat(data[i]);
+   #endif
+
+    stream.flush();
+    return stream.getStatus().wasOk();
+}
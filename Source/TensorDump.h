@@ -0,0 +1,74 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Utilities.h"
+
+/**
+    Dumps tensors from inference to .npy files, for inspecting a run from Python.
+
+    Off by default, when it costs inference one check per run. Once enabled, each
+    run gets its own folder, and the tensors captured at the chosen steps are
+    copied into memory as the run goes. Nothing touches the disk until the run
+    ends, when its files are written in one buffered write each on a background
+    thread, so timings with dumping on stay close to those without.
+
+    Can also be enabled from the start by setting CRASHHFY_TENSOR_DUMP to a
+    folder, and CRASHHFY_TENSOR_DUMP_STEPS to a comma-separated list of steps.
+*/
+class TensorDump
+{
+public:
+    /** The tensors captured in one run, written out when it is destroyed. */
+    class Run
+    {
+    public:
+        Run(TensorDump& owner, const juce::File& folder, std::vector<int> steps);
+        ~Run();
+
+        bool wantsStep(int step) const;
+
+        // Copies the tensor, as step<step>_<name>.npy
+        void capture(int step, const juce::String& name, const float* data, std::vector<size_t> shape);
+
+    private:
+        struct Tensor
+        {
+            juce::File file;
+            std::vector<float> data;
+            std::vector<size_t> shape;
+        };
+
+        TensorDump& _owner;
+        const juce::File _folder;
+        const std::vector<int> _steps;
+        std::vector<Tensor> _tensors;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Run)
+    };
+
+    TensorDump();
+    ~TensorDump();
+
+    // Runs from then on are dumped into folders in directory. Every step is captured if steps is empty.
+    void enable(const juce::File& directory, std::vector<int> steps = {});
+    void disable();
+    bool isEnabled() const;
+
+    // nullptr while disabled
+    std::unique_ptr<Run> beginRun();
+
+    // Float32 in C order, as numpy.load expects
+    static bool writeNpy(const juce::File& file, const float* data, const std::vector<size_t>& shape);
+
+private:
+    std::atomic<bool> _isEnabled{ false };
+    std::atomic<int> _numRuns{ 0 };
+
+    juce::CriticalSection _lock;
+    juce::File _directory;
+    std::vector<int> _steps;
+
+    juce::ThreadPool _writer{ 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TensorDump)
+};
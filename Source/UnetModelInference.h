@@ -8,6 +8,7 @@ LICENSE: MIT
 
 #include "onnxruntime_cxx_api.h"
 #include "crash.ort.h"
+#include "TensorDump.h"
 
 #include <vector>
 #include <array>
@@ -35,23 +36,22 @@ public:
         mOutputNames = GetOutputNames();
 
         // Fix the input/output shapes so that they are (1, outputSize)
-        mInputShapes[0] = {1, outputSize};
-        mOutputShapes[0] = {1, outputSize};
-
-        mXScratch.resize(outputSize);
-        mYScratch.resize(outputSize);
-        mNoise.resize(outputSize);
+        SetBatchSize(1);
 
         mInpaintScratch.resize(outputSize);
-
-
-        mOutputTensors.push_back(
-                Ort::Value::CreateTensor<float>(info, mYScratch.data(), mYScratch.size(), mOutputShapes[0].data(),
-                                                mOutputShapes[0].size()));
-
     }
 
     void process(float *output, size_t numSteps) {
+        process(output, numSteps, rnd_device());
+    }
+
+    // The same seed and number of steps always give the same output
+    void process(float *output, size_t numSteps, uint32_t seed) {
+        SetBatchSize(1);
+        mLastSeed = seed;
+        mersenne_engine.seed(seed);
+        d.reset();
+
         // Noise Input
         for (size_t i = 0; i < outputSize; i++)
             mXScratch[i] = d(mersenne_engine);
@@ -60,13 +60,23 @@ public:
     }
 
     void processSeeded(float *output, const float* seedAudio, size_t numSteps) {
+        processSeededBatch(output, seedAudio, 1, numSteps);
+    }
+
+    // Drumifies batchSize inputs of outputSize samples each, laid out one after another, in one
+    // diffusion run. Every step is a single model call for the whole batch.
+    void processSeededBatch(float *output, const float* seedAudio, size_t batchSize, size_t numSteps) {
+        SetBatchSize(batchSize);
+
         // Audio Input
-        memcpy(mXScratch.data(), seedAudio, outputSize * sizeof (float));
+        memcpy(mXScratch.data(), seedAudio, mXScratch.size() * sizeof (float));
         RunInference(numSteps);
-        memcpy(output, mYScratch.data(), outputSize * sizeof(float));
+        memcpy(output, mYScratch.data(), mYScratch.size() * sizeof(float));
     }
 
     void processSeededInpainting(float *output, const float* seedAudio, bool paintHalf, size_t numSteps) {
+        SetBatchSize(1);
+
         // Noise Input
         for (size_t i = 0; i < outputSize; i++)
             mXScratch[i] = d(mersenne_engine);
@@ -77,8 +87,35 @@ public:
     }
 
 
+    uint32_t getLastSeed() const {
+        return mLastSeed;
+    }
+
 private:
+    void SetBatchSize(size_t batchSize) {
+        if (batchSize == mBatchSize)
+            return;
+
+        mBatchSize = batchSize;
+        mInputShapes[0] = {static_cast<int64_t>(batchSize), outputSize};
+        mOutputShapes[0] = {static_cast<int64_t>(batchSize), outputSize};
+
+        mXScratch.resize(batchSize * outputSize);
+        mYScratch.resize(batchSize * outputSize);
+        mNoise.resize(batchSize * outputSize);
+
+        // The output tensor refers to mYScratch, which may have moved
+        mOutputTensors.clear();
+        mOutputTensors.push_back(
+                Ort::Value::CreateTensor<float>(info, mYScratch.data(), mYScratch.size(), mOutputShapes[0].data(),
+                                                mOutputShapes[0].size()));
+    }
+
     void RunInference(size_t numSteps, bool inpainting = false, bool paintHalf = 0) {
+        // Only set while dumping is enabled, and copies tensors into memory until the run ends
+        auto dump = mTensorDump->beginRun();
+        const std::vector<size_t> shape = {mBatchSize, outputSize};
+
         // Initialize variables
         auto [s, m] = create_schedules(numSteps);
         mSig = s;
@@ -99,25 +136,33 @@ private:
         // Begin diffusion
         for (size_t n = numSteps - 1; n > 0; n--) {
             sigVal = {static_cast<double>(mSig[n])};
+            if (dump)
+                dump->capture(int(n), "x", mXScratch.data(), shape);
+
             mSession->Run(mRunOptions, inputNamesCstrs, mInputTensors.data(), mInputTensors.size(), outputNamesCstrs,
                           mOutputTensors.data(), mOutputTensors.size());
+            if (dump)
+                dump->capture(int(n), "y", mYScratch.data(), shape);
 
             // Create gaussian noise based on noise schedule
-            for (size_t i = 0; i < outputSize; i++) {
+            for (size_t i = 0; i < mNoise.size(); i++) {
                 float newNoise = d(mersenne_engine);
                 mNoise[i] =
                         mSig[n - 1] * powf(1.0f - powf(mSig[n - 1] * mMean[n] / (mSig[n] * mMean[n - 1]), 2.0f), 0.5f) *
                         newNoise;
             }
+            if (dump)
+                dump->capture(int(n), "noise", mNoise.data(), shape);
+
             float scale =
                     (mMean[n] / mMean[n - 1]) * powf(mSig[n - 1], 2.0f) / mSig[n] - mMean[n - 1] / mMean[n] * mSig[n];
 
             // mYScratch contains noise
             // Next input is current input + scaled output + new noise
-            for (size_t i = 0; i < outputSize; i++)
+            for (size_t i = 0; i < mXScratch.size(); i++)
                 mXScratch[i] = (mMean[n - 1] / mMean[n]) * mXScratch[i] + scale * mYScratch[i] + mNoise[i];
 
-            // Inpainting
+            // Inpainting, which only runs with a batch of one
             if (inpainting) {
                 size_t midPoint = outputSize / 2;
                 // Create noise
@@ -145,10 +190,19 @@ private:
         std::vector<float> diffuseOut = mXScratch;
         sigVal = {static_cast<double>(mSig[0])};
         float scale = mSig[0];
+        if (dump)
+            dump->capture(0, "x", mXScratch.data(), shape);
+
         mSession->Run(mRunOptions, inputNamesCstrs, mInputTensors.data(), mInputTensors.size(), outputNamesCstrs,
                       mOutputTensors.data(), mOutputTensors.size());
-        for (size_t i = 0; i < outputSize; i++)
+        if (dump)
+            dump->capture(0, "y", mYScratch.data(), shape);
+
+        for (size_t i = 0; i < mYScratch.size(); i++)
             mYScratch[i] = (diffuseOut[i] - scale * mYScratch[i]) / mMean[0];
+
+        if (dump)
+            dump->capture(0, "output", mYScratch.data(), shape);
     }
 
     inline std::vector<std::vector<int64_t>> GetInputShapes() const {
@@ -225,6 +279,9 @@ private:
     std::vector<float> mNoise;          // noise temp
     std::vector<double> sigVal = {0.0}; // sigma input
     std::vector<float> mInpaintScratch;
+    size_t mBatchSize = 0;
+
+    juce::SharedResourcePointer<TensorDump> mTensorDump;
 
     std::vector<Ort::Value> mInputTensors;
     std::vector<std::vector<int64_t>> mInputShapes;
@@ -238,6 +295,7 @@ private:
     std::random_device rnd_device;              // random generator
     std::mt19937 mersenne_engine{rnd_device()}; // Generates random integers
     std::normal_distribution<float> d{0, 1};
+    uint32_t mLastSeed = 0;
 
     float t_min = 0.007f;
     float t_max = 1.0f - 0.007f;
@@ -4,16 +4,6 @@
 
 struct Utils
 {
-    static void saveBufferToFile(const juce::String& file, const float* x, int numSamples)
-    {
-        juce::File f{ file };
-        f.deleteFile();
-        f.create();
-
-        for (int i = 0; i < numSamples; i++)
-            f.appendText(juce::String(x[i]) + "\n");
-    }
-
     static void makeSine(float* x, int numSamples, float f, double fs)
     {
         // Sine wave input signal
@@ -23,48 +13,90 @@ struct Utils
             x[i] = std::sin(w * i);
     }
 
-    static std::pair<juce::AudioBuffer<float>, double> readWavFile(const juce::File& file)
+    // 16 or 24-bit integer, or 32-bit float. Written to a temporary file beside the target and moved
+    // over it once complete, so a failed write leaves any existing file as it was.
+    static bool writeWavFile(const juce::AudioBuffer<float>& data, double sampleRate, const juce::File& file, int numBits = 16)
     {
         jassert(file.hasFileExtension(".wav"));
+        jassert(numBits == 16 || numBits == 24 || numBits == 32);
 
-        juce::WavAudioFormat format;
-        auto reader = std::unique_ptr<juce::AudioFormatReader>(format.createReaderFor(new juce::FileInputStream(file), true));
+        // Large enough that a drum is written in a handful of calls to the OS
+        static constexpr size_t bufferSize = 1 << 18;
 
-        if (reader == nullptr)
-            return { {}, 0.0 };
+        juce::TemporaryFile temp{ file };
 
-        auto numChannels = int(reader->numChannels);
-        auto numSamples = int(reader->lengthInSamples);
+        {
+            auto stream = std::make_unique<juce::FileOutputStream>(temp.getFile(), bufferSize);
 
-        jassert(numSamples == int(reader->lengthInSamples));
+            if (!stream->openedOk())
+                return false;
 
-        juce::AudioBuffer<float> data;
-        data.setSize(numChannels, numSamples);
-        reader->read(data.getArrayOfWritePointers(), numChannels, 0, numSamples);
-        
-        return { std::move(data), reader->sampleRate };
-    }
+            juce::WavAudioFormat format;
+            std::unique_ptr<juce::AudioFormatWriter> writer{ format.createWriterFor(stream.get(),
+                                                                                     sampleRate,
+                                                                                     juce::uint32(data.getNumChannels()),
+                                                                                     numBits,
+                                                                                     {},
+                                                                                     0) };
+
+            if (writer == nullptr)
+                return false;
 
-    static void writeWavFile(const juce::AudioBuffer<float>& data, double sampleRate, const juce::File& file)
+            // Owned by the writer from here
+            stream.release();
+
+            if (!writer->writeFromAudioSampleBuffer(data, 0, data.getNumSamples()))
+                return false;
+        }
+
+        return temp.overwriteTargetFileWithTemporary();
+    }
+    
+    // 24-bit FLAC, which holds normalised audio without audible loss at around half the size of raw 24-bit
+    static juce::MemoryBlock encodeFlac(const juce::AudioBuffer<float>& data, double sampleRate)
     {
-        jassert(file.hasFileExtension(".wav"));
-        file.deleteFile();
-        file.create();
+        static constexpr juce::uint32 numBits = 24;
+        juce::MemoryBlock block;
+        juce::FlacAudioFormat format;
 
-        static constexpr juce::uint32 numBits = 16;
-        juce::WavAudioFormat format;
+        auto stream = std::make_unique<juce::MemoryOutputStream>(block, false);
         std::unique_ptr<juce::AudioFormatWriter> writer;
-        writer.reset(format.createWriterFor(new juce::FileOutputStream{ file },
+        writer.reset(format.createWriterFor(stream.get(),
                                             sampleRate,
-                                            data.getNumChannels(),
-                                            numBits,
+                                            juce::uint32(data.getNumChannels()),
+                                            int(numBits),
                                             {},
                                             0));
 
-        if (writer != nullptr)
-            writer->writeFromAudioSampleBuffer(data, 0, data.getNumSamples());
+        if (writer == nullptr)
+            return {};
+
+        // The writer now owns the stream, and flushes it when destroyed
+        stream.release();
+        writer->writeFromAudioSampleBuffer(data, 0, data.getNumSamples());
+        writer.reset();
+
+        return block;
     }
-    
+
+    static std::pair<juce::AudioBuffer<float>, double> decodeFlac(const juce::MemoryBlock& block)
+    {
+        juce::FlacAudioFormat format;
+        auto reader = std::unique_ptr<juce::AudioFormatReader>(format.createReaderFor(new juce::MemoryInputStream(block, false), true));
+
+        if (reader == nullptr)
+            return { {}, 0.0 };
+
+        auto numChannels = int(reader->numChannels);
+        auto numSamples = int(reader->lengthInSamples);
+
+        juce::AudioBuffer<float> data;
+        data.setSize(numChannels, numSamples);
+        reader->read(data.getArrayOfWritePointers(), numChannels, 0, numSamples);
+
+        return { std::move(data), reader->sampleRate };
+    }
+
     static void applyFade(float* data, int startSample, int numSamples, bool fadeIn = true)
     {
         if (fadeIn)
@@ -79,6 +111,27 @@ struct Utils
         }
     }
 
+    static juce::int64 hashBuffer(const juce::AudioBuffer<float>& buffer)
+    {
+        // 64-bit FNV-1a over the raw sample data, used to identify sample content
+        juce::uint64 h = 14695981039346656037ull;
+
+        auto mix = [&h](const void* data, size_t numBytes)
+        {
+            auto bytes = static_cast<const juce::uint8*>(data);
+            for (size_t i = 0; i < numBytes; i++)
+                h = (h ^ bytes[i]) * 1099511628211ull;
+        };
+
+        int dims[] = { buffer.getNumChannels(), buffer.getNumSamples() };
+        mix(dims, sizeof(dims));
+
+        for (int j = 0; j < buffer.getNumChannels(); j++)
+            mix(buffer.getReadPointer(j), size_t(buffer.getNumSamples()) * sizeof(float));
+
+        return juce::int64(h);
+    }
+
     static void normalize(juce::AudioBuffer<float>& buffer)
     {
         auto ptr = buffer.getArrayOfWritePointers();
@@ -97,6 +150,14 @@ struct Utils
             for (int i = 0; i < buffer.getNumSamples(); i++)
                 ptr[j][i] /= max;
     }
+
+    // Blocks until every job added to pool has run. A ThreadPool drops jobs that haven't started when
+    // it is destroyed, so owners of pools that write files call this as they go away.
+    static void waitForJobs(juce::ThreadPool& pool)
+    {
+        while (pool.getNumJobs() > 0)
+            juce::Thread::sleep(10);
+    }
 };
 
 struct ParameterDefinition
@@ -107,56 +168,3 @@ struct ParameterDefinition
     juce::NormalisableRange<float> range;
     float defaultValue;
 };
-
-class DummyProcessor : public juce::AudioProcessor
-{
-public:
-    DummyProcessor() = default;
-    ~DummyProcessor() override = default;
-
-private:
-    bool isBusesLayoutSupported (const BusesLayout&) const override { return false; }
-    void prepareToPlay(double, int) override {}
-    void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
-    void releaseResources() override {}
-    void getStateInformation (juce::MemoryBlock&) override {}
-    void setStateInformation (const void*, int) override {}
-    bool hasEditor() const override { return false; }
-    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
-    const juce::String getName() const override { return ""; }
-    bool acceptsMidi() const override { return false; }
-    bool producesMidi() const override { return false; }
-    bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 0.0; }
-    int getNumPrograms() override { return 0; }
-    int getCurrentProgram() override { return 0; }
-    void setCurrentProgram(int) override {}
-    const juce::String getProgramName(int) override { return ""; }
-    void changeProgramName(int, const juce::String&) override {}
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DummyProcessor)
-};
-
-class ParameterListener : public juce::AudioProcessorParameter::Listener
-{
-public:
-    ParameterListener(juce::RangedAudioParameter& param, std::function<void(float)> func)
-        : param(param), _func(std::move(func))
-    {
-        jassert(_func != nullptr);
-        param.addListener(this);
-    }
-
-private:
-    void parameterValueChanged(int, float newValue) override
-    {
-        _func(param.convertFrom0to1(newValue));
-    }
-
-    void parameterGestureChanged(int, bool) override {}
-
-    juce::RangedAudioParameter& param;
-    std::function<void(float)> _func;
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterListener)
-};
@@ -0,0 +1,187 @@
+#include "VoiceLanes.h"
+
+void VoiceLanes::prepare(int maxNumVoices)
+{
+    jassert(maxNumVoices > 0);
+
+    auto n = size_t(maxNumVoices);
+    _voices.allocate(n, true);
+    _dataLeft.allocate(n, true);
+    _dataRight.allocate(n, true);
+    _numRemaining.allocate(n, true);
+    _level.allocate(n, true);
+    _rate.allocate(n, true);
+    _lowerBound.allocate(n, true);
+    _upperBound.allocate(n, true);
+    _segmentLength.allocate(n, true);
+    _gainLeft.allocate(n, true);
+    _gainRight.allocate(n, true);
+
+    _maxNumLanes = maxNumVoices;
+    _numLanes = 0;
+}
+
+void VoiceLanes::render(Voice* const* voices, int numVoices, float* outL, float* outR, int numSamples)
+{
+    jassert(numVoices <= _maxNumLanes);
+
+    _numLanes = 0;
+
+    for (int i = 0; i < numVoices; i++)
+    {
+        auto& voice = *voices[i];
+
+        if (voice._sound != nullptr && !voice._sound->isEmpty() && !voice.isInaudible() && voice.readsDirectly())
+        {
+            voice._tail.readAdd(outL, outR, numSamples);
+            addLane(voice);
+        }
+        else
+        {
+            voice.render(outL, outR, numSamples);
+        }
+    }
+
+    int i = 0;
+
+    while (i < numSamples && _numLanes > 0)
+    {
+        // Runs stop wherever a lane reaches the end of its sample or envelope segment
+        auto numToRender = juce::jmin(numSamples - i, maxRunLength);
+
+        for (int l = 0; l < _numLanes; l++)
+            numToRender = juce::jmin(numToRender, _numRemaining[l], _segmentLength[l]);
+
+        mixLanes(outL + i, outR + i, numToRender);
+        advanceLanes(numToRender);
+
+        i += numToRender;
+    }
+
+    _numLanes = 0;
+}
+
+void VoiceLanes::addLane(Voice& voice)
+{
+    jassert(_numLanes < _maxNumLanes);
+
+    auto l = _numLanes++;
+    auto& sample = voice._sample->data;
+    auto position = int(voice._currentIdx);
+
+    _voices[l] = &voice;
+
+    // Mono samples feed both sides
+    _dataLeft[l] = sample.getReadPointer(0, position);
+    _dataRight[l] = sample.getReadPointer(sample.getNumChannels() - 1, position);
+    _numRemaining[l] = juce::jmax(0, voice.getEndIndex() - position);
+
+    voice.updateGains();
+    _gainLeft[l] = voice._gainLeft;
+    _gainRight[l] = voice._gainRight;
+
+    updateEnvelope(l);
+}
+
+void VoiceLanes::updateEnvelope(int lane)
+{
+    auto& envelope = _voices[lane]->_envelope;
+    auto segment = envelope.getSegment();
+
+    // A flat segment holds its target, which is what the envelope renders while sustaining
+    auto level = segment.rate == 0.0f ? segment.target : envelope.getLevel();
+
+    _level[lane] = level;
+    _rate[lane] = segment.rate;
+    _lowerBound[lane] = juce::jmin(level, segment.target);
+    _upperBound[lane] = juce::jmax(level, segment.target);
+
+    // A finished envelope ends the lane before anything more is rendered
+    _segmentLength[lane] = envelope.isActive() ? segment.numSamples : 0;
+}
+
+void VoiceLanes::removeLane(int lane)
+{
+    auto last = --_numLanes;
+
+    if (lane == last)
+        return;
+
+    _voices[lane] = _voices[last];
+    _dataLeft[lane] = _dataLeft[last];
+    _dataRight[lane] = _dataRight[last];
+    _numRemaining[lane] = _numRemaining[last];
+    _level[lane] = _level[last];
+    _rate[lane] = _rate[last];
+    _lowerBound[lane] = _lowerBound[last];
+    _upperBound[lane] = _upperBound[last];
+    _segmentLength[lane] = _segmentLength[last];
+    _gainLeft[lane] = _gainLeft[last];
+    _gainRight[lane] = _gainRight[last];
+}
+
+void VoiceLanes::mixLanes(float* outL, float* outR, int numSamples) const
+{
+    for (int k = 0; k < numSamples; k += blockSize)
+    {
+        auto blockStart = float(k);
+
+        float accLeft[blockSize] = {};
+        float accRight[blockSize] = {};
+        float envelope[blockSize];
+
+        for (int l = 0; l < _numLanes; l++)
+        {
+            // Always a whole block, which can read up to blockSize - 1 samples into the sample's end guard
+            auto inL = _dataLeft[l] + k;
+            auto inR = _dataRight[l] + k;
+
+            auto level = _level[l];
+            auto rate = _rate[l];
+            auto lower = _lowerBound[l];
+            auto upper = _upperBound[l];
+
+            // Kept as separate loops so that each one vectorises
+            for (int j = 0; j < blockSize; j++)
+                envelope[j] = juce::jmin(upper, juce::jmax(lower, level + (blockStart + float(j + 1)) * rate));
+
+            auto gainLeft = _gainLeft[l];
+            auto gainRight = _gainRight[l];
+
+            for (int j = 0; j < blockSize; j++)
+            {
+                accLeft[j] += inL[j] * envelope[j] * gainLeft;
+                accRight[j] += inR[j] * envelope[j] * gainRight;
+            }
+        }
+
+        auto n = juce::jmin(blockSize, numSamples - k);
+        juce::FloatVectorOperations::add(outL + k, accLeft, n);
+        juce::FloatVectorOperations::add(outR + k, accRight, n);
+    }
+}
+
+void VoiceLanes::advanceLanes(int numSamples)
+{
+    for (int l = _numLanes; --l >= 0;)
+    {
+        auto& voice = *_voices[l];
+
+        voice._currentIdx += numSamples;
+        voice._envelope.advance(numSamples);
+
+        _dataLeft[l] += numSamples;
+        _dataRight[l] += numSamples;
+        _numRemaining[l] -= numSamples;
+
+        if (_numRemaining[l] <= 0 || !voice._envelope.isActive() || voice.isInaudible())
+        {
+            voice.endNote();
+            removeLane(l);
+        }
+        else
+        {
+            updateEnvelope(l);
+        }
+    }
+}
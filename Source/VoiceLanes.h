@@ -0,0 +1,60 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Sampler.h"
+
+/**
+    Renders many voices together from structure-of-arrays playback state.
+
+    Voices that read their sample directly, which is every voice once its
+    pre-pitched sample is ready, are packed into lanes: one entry per voice in
+    each of the read pointer, remaining length, envelope and gain arrays. Each
+    pass renders a short run over which no lane's envelope changes segment, so
+    every lane is a plain line times contiguous sample data. Lanes accumulate
+    into a few registers' worth of output at a time, so the output is written
+    once per run however many voices are playing.
+
+    Voices that need interpolation are rendered one at a time as before.
+*/
+class VoiceLanes
+{
+public:
+    VoiceLanes() = default;
+    ~VoiceLanes() = default;
+
+    void prepare(int maxNumVoices);
+
+    // Adds numSamples of every voice's output to outL/outR
+    void render(Voice* const* voices, int numVoices, float* outL, float* outR, int numSamples);
+
+private:
+    // Output samples accumulated per lane before moving to the next lane
+    static constexpr int blockSize{ 32 };
+    static constexpr int maxRunLength{ 256 };
+
+    static_assert(blockSize - 1 <= Sample::numGuardSamples, "Sample guard is too short for whole-block reads");
+
+    void addLane(Voice& voice);
+    void updateEnvelope(int lane);
+    void removeLane(int lane);
+
+    void mixLanes(float* outL, float* outR, int numSamples) const;
+    void advanceLanes(int numSamples);
+
+    int _maxNumLanes{ 0 };
+    int _numLanes{ 0 };
+
+    juce::HeapBlock<Voice*> _voices;
+    juce::HeapBlock<const float*> _dataLeft, _dataRight;
+
+    // Output samples left before each lane's read position reaches the last sample
+    juce::HeapBlock<int> _numRemaining;
+
+    // The envelope segment each lane is on, with lower and upper bounds from its level and target
+    juce::HeapBlock<float> _level, _rate, _lowerBound, _upperBound;
+    juce::HeapBlock<int> _segmentLength;
+
+    juce::HeapBlock<float> _gainLeft, _gainRight;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(VoiceLanes)
+};
@@ -15,6 +15,27 @@ device = torch.device("cpu")
 model_dir = os.getcwd() + "/saved_weights/weights_vp.pt"
 
 
+class ClassifierWithEmbedding(torch.nn.Module):
+    """Returns the classifier's output along with the input to its last layer,
+    which the plugin uses to find similar drums."""
+
+    def __init__(self, classifier):
+        super().__init__()
+        self.classifier = classifier
+        self.head = [m for m in classifier.modules() if isinstance(m, torch.nn.Linear)][-1]
+
+    def forward(self, audio, noise_scale):
+        embedding = []
+        handle = self.head.register_forward_hook(
+            lambda module, inputs, output: embedding.append(inputs[0])
+        )
+        try:
+            output = self.classifier(audio, noise_scale)
+        finally:
+            handle.remove()
+        return output, embedding[0].flatten(1)
+
+
 def load_ema_weights(model, model_dir):
     checkpoint = torch.load(model_dir, map_location=torch.device("cpu"))
     dic_ema = {}
@@ -50,12 +71,16 @@ def main():
 
     print("Exporting Classifier...")
     onnx_export(
-        classifier,
+        ClassifierWithEmbedding(classifier),
         model_args=(noise, 0.99),
         output_path=output_path / "classifier.onnx",
         ordered_input_names=["audio", "noise_scale"],
-        output_names=["output"],
-        dynamic_axes={"audio": {0: "batch_size"}, "output": {0: "batch_size"}},
+        output_names=["output", "embedding"],
+        dynamic_axes={
+            "audio": {0: "batch_size"},
+            "output": {0: "batch_size"},
+            "embedding": {0: "batch_size"},
+        },
         training=False,
     )
 
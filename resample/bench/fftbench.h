@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+/**
+    Each FFT backend is compiled in its own translation unit, since the r8b
+    headers select the backend with preprocessor definitions.
+*/
+
+namespace bench
+{
+
+struct Backend
+{
+    const char* name;
+
+    // Seconds per forward + inverse transform pair of 2^lenBits real values
+    double (*timeTransform)(int lenBits, int numIterations);
+
+    // Circular convolution of two 2^lenBits sequences computed through the FFT
+    std::vector<double> (*convolve)(const std::vector<double>& x, const std::vector<double>& h, int lenBits);
+
+    // Full resampler pass, returning the seconds taken in elapsed
+    std::vector<double> (*resample)(const std::vector<double>& x, double sourceFs, double destFs, double& elapsed);
+};
+
+const Backend& getFft4gBackend();
+const Backend& getPffftdBackend();
+
+}
@@ -0,0 +1,16 @@
+// Builds the library's scalar fft4g path into a separate namespace, next to the PFFFT build
+#undef R8B_PFFFT_DOUBLE
+#define R8B_PFFFT_DOUBLE 0
+#define r8b r8b_fft4g
+
+#include "../r8b/r8bbase.cpp"
+#include "../r8b/CDSPResampler.h"
+
+#include "fftbench.h"
+#include "fftbench_backend.inc"
+
+const bench::Backend& bench::getFft4gBackend()
+{
+    static const Backend backend{ "fft4g", timeTransform, convolve, resample };
+    return backend;
+}
@@ -0,0 +1,14 @@
+#include "../r8b/CDSPResampler.h"
+
+#include "fftbench.h"
+#include "fftbench_backend.inc"
+
+#if !R8B_PFFFT_DOUBLE
+    #error The benchmark expects the r8b library to be built with R8B_PFFFT_DOUBLE=1
+#endif
+
+const bench::Backend& bench::getPffftdBackend()
+{
+    static const Backend backend{ "pffftd", timeTransform, convolve, resample };
+    return backend;
+}
@@ -0,0 +1,8 @@
+/**
+    AVX build of pffft_double. CMake compiles this file with AVX enabled on x86
+    targets; the dispatcher only selects it when the CPU reports AVX support.
+*/
+
+#define PFFFTD_VARIANT avx
+#include "pffftd_rename.h"
+#include "../r8b/pffft_double/pffft_double.c"
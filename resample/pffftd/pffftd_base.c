@@ -0,0 +1,8 @@
+/**
+    Baseline build of pffft_double, using the target's default instruction set
+    (SSE2 on x86-64, NEON on arm64).
+*/
+
+#define PFFFTD_VARIANT base
+#include "pffftd_rename.h"
+#include "../r8b/pffft_double/pffft_double.c"
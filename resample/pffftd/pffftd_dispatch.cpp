@@ -0,0 +1,166 @@
+#include "pffftd_dispatch.h"
+
+#if defined(_MSC_VER) && !defined(__clang__) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+#endif
+
+#define PFFFTD_DECLARE_VARIANT(v)                                                                                       \
+    extern "C" {                                                                                                        \
+        PFFFTD_Setup* pffftd_new_setup_##v(int, pffft_transform_t);                                                     \
+        void pffftd_destroy_setup_##v(PFFFTD_Setup*);                                                                   \
+        void pffftd_transform_##v(PFFFTD_Setup*, const double*, double*, double*, pffft_direction_t);                   \
+        void pffftd_transform_ordered_##v(PFFFTD_Setup*, const double*, double*, double*, pffft_direction_t);           \
+        void pffftd_zreorder_##v(PFFFTD_Setup*, const double*, double*, pffft_direction_t);                             \
+        void pffftd_zconvolve_accumulate_##v(PFFFTD_Setup*, const double*, const double*, double*, double);             \
+        void pffftd_zconvolve_no_accu_##v(PFFFTD_Setup*, const double*, const double*, double*, double);                \
+        int pffftd_simd_size_##v();                                                                                     \
+        const char* pffftd_simd_arch_##v();                                                                             \
+        int pffftd_min_fft_size_##v(pffft_transform_t);                                                                 \
+        int pffftd_next_power_of_two_##v(int);                                                                          \
+        int pffftd_is_power_of_two_##v(int);                                                                            \
+        void* pffftd_aligned_malloc_##v(size_t);                                                                        \
+        void pffftd_aligned_free_##v(void*);                                                                            \
+    }
+
+#define PFFFTD_BACKEND(v, name)                                                                                         \
+    {                                                                                                                   \
+        r8b::PffftdBackend::v, name,                                                                                    \
+        pffftd_new_setup_##v, pffftd_destroy_setup_##v, pffftd_transform_##v, pffftd_transform_ordered_##v,             \
+        pffftd_zreorder_##v, pffftd_zconvolve_accumulate_##v, pffftd_zconvolve_no_accu_##v,                             \
+        pffftd_simd_size_##v, pffftd_simd_arch_##v, pffftd_min_fft_size_##v                                             \
+    }
+
+PFFFTD_DECLARE_VARIANT(base)
+PFFFTD_DECLARE_VARIANT(avx)
+
+namespace
+{
+
+const r8b::PffftdBackend backends[r8b::PffftdBackend::numVariants] = {
+    PFFFTD_BACKEND(base, "base"),
+    PFFFTD_BACKEND(avx, "avx")
+};
+
+bool cpuSupportsAvx()
+{
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+
+        // AVX needs both CPU support and the OS saving the YMM registers
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        return osxsave && avx && (_xgetbv(0) & 6) == 6;
+    #else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx") != 0;
+    #endif
+#else
+    return false;
+#endif
+}
+
+const r8b::PffftdBackend& selectBackend()
+{
+    static const r8b::PffftdBackend& selected = cpuSupportsAvx() ? backends[r8b::PffftdBackend::avx]
+                                                                 : backends[r8b::PffftdBackend::base];
+    return selected;
+}
+
+}
+
+namespace r8b
+{
+
+const PffftdBackend* getPffftdBackend(PffftdBackend::Variant variant)
+{
+    if (variant == PffftdBackend::avx && !cpuSupportsAvx())
+        return nullptr;
+
+    return &backends[variant];
+}
+
+const PffftdBackend& getSelectedPffftdBackend()
+{
+    return selectBackend();
+}
+
+}
+
+extern "C" {
+
+PFFFTD_Setup* pffftd_new_setup(int N, pffft_transform_t transform)
+{
+    return selectBackend().newSetup(N, transform);
+}
+
+void pffftd_destroy_setup(PFFFTD_Setup* setup)
+{
+    selectBackend().destroySetup(setup);
+}
+
+void pffftd_transform(PFFFTD_Setup* setup, const double* input, double* output, double* work, pffft_direction_t direction)
+{
+    selectBackend().transform(setup, input, output, work, direction);
+}
+
+void pffftd_transform_ordered(PFFFTD_Setup* setup, const double* input, double* output, double* work, pffft_direction_t direction)
+{
+    selectBackend().transformOrdered(setup, input, output, work, direction);
+}
+
+void pffftd_zreorder(PFFFTD_Setup* setup, const double* input, double* output, pffft_direction_t direction)
+{
+    selectBackend().zreorder(setup, input, output, direction);
+}
+
+void pffftd_zconvolve_accumulate(PFFFTD_Setup* setup, const double* dft_a, const double* dft_b, double* dft_ab, double scaling)
+{
+    selectBackend().zconvolveAccumulate(setup, dft_a, dft_b, dft_ab, scaling);
+}
+
+void pffftd_zconvolve_no_accu(PFFFTD_Setup* setup, const double* dft_a, const double* dft_b, double* dft_ab, double scaling)
+{
+    selectBackend().zconvolveNoAccu(setup, dft_a, dft_b, dft_ab, scaling);
+}
+
+int pffftd_simd_size()
+{
+    return selectBackend().simdSize();
+}
+
+const char* pffftd_simd_arch()
+{
+    return selectBackend().simdArch();
+}
+
+int pffftd_min_fft_size(pffft_transform_t transform)
+{
+    return selectBackend().minFftSize(transform);
+}
+
+// The remaining functions do not depend on the instruction set
+
+int pffftd_next_power_of_two(int N)
+{
+    return pffftd_next_power_of_two_base(N);
+}
+
+int pffftd_is_power_of_two(int N)
+{
+    return pffftd_is_power_of_two_base(N);
+}
+
+void* pffftd_aligned_malloc(size_t nb_bytes)
+{
+    return pffftd_aligned_malloc_base(nb_bytes);
+}
+
+void pffftd_aligned_free(void* p)
+{
+    pffftd_aligned_free_base(p);
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "../r8b/pffft_double/pffft_double.h"
+
+/**
+    Runtime selection between the pffft_double builds linked into the r8b
+    library. The pffftd_* C functions used by CDSPRealFFT forward to the
+    backend chosen on first use, based on the CPU features reported at runtime.
+*/
+
+namespace r8b
+{
+
+struct PffftdBackend
+{
+    enum Variant
+    {
+        base = 0,
+        avx,
+        numVariants
+    };
+
+    Variant variant;
+    const char* name;
+
+    PFFFTD_Setup* (*newSetup)(int, pffft_transform_t);
+    void (*destroySetup)(PFFFTD_Setup*);
+    void (*transform)(PFFFTD_Setup*, const double*, double*, double*, pffft_direction_t);
+    void (*transformOrdered)(PFFFTD_Setup*, const double*, double*, double*, pffft_direction_t);
+    void (*zreorder)(PFFFTD_Setup*, const double*, double*, pffft_direction_t);
+    void (*zconvolveAccumulate)(PFFFTD_Setup*, const double*, const double*, double*, double);
+    void (*zconvolveNoAccu)(PFFFTD_Setup*, const double*, const double*, double*, double);
+    int (*simdSize)();
+    const char* (*simdArch)();
+    int (*minFftSize)(pffft_transform_t);
+};
+
+// Returns the given build, or nullptr if the running CPU cannot execute it
+const PffftdBackend* getPffftdBackend(PffftdBackend::Variant variant);
+
+// The build selected for this process
+const PffftdBackend& getSelectedPffftdBackend();
+
+}
@@ -0,0 +1,33 @@
+/**
+    Gives every external symbol of pffft_double.c a per-variant suffix, so the
+    library can be compiled several times with different instruction sets and
+    linked into the same binary. PFFFTD_VARIANT must be defined by the includer.
+*/
+
+#ifndef PFFFTD_VARIANT
+    #error PFFFTD_VARIANT must be defined before including pffftd_rename.h
+#endif
+
+#define PFFFTD_CONCAT_(name, variant) name##_##variant
+#define PFFFTD_CONCAT(name, variant) PFFFTD_CONCAT_(name, variant)
+#define PFFFTD_RENAME(name) PFFFTD_CONCAT(name, PFFFTD_VARIANT)
+
+#define pffftd_new_setup                PFFFTD_RENAME(pffftd_new_setup)
+#define pffftd_destroy_setup            PFFFTD_RENAME(pffftd_destroy_setup)
+#define pffftd_transform                PFFFTD_RENAME(pffftd_transform)
+#define pffftd_transform_ordered        PFFFTD_RENAME(pffftd_transform_ordered)
+#define pffftd_zreorder                 PFFFTD_RENAME(pffftd_zreorder)
+#define pffftd_zconvolve_accumulate     PFFFTD_RENAME(pffftd_zconvolve_accumulate)
+#define pffftd_zconvolve_no_accu        PFFFTD_RENAME(pffftd_zconvolve_no_accu)
+#define pffftd_aligned_malloc           PFFFTD_RENAME(pffftd_aligned_malloc)
+#define pffftd_aligned_free             PFFFTD_RENAME(pffftd_aligned_free)
+#define pffftd_simd_size                PFFFTD_RENAME(pffftd_simd_size)
+#define pffftd_simd_arch                PFFFTD_RENAME(pffftd_simd_arch)
+#define pffftd_next_power_of_two        PFFFTD_RENAME(pffftd_next_power_of_two)
+#define pffftd_is_power_of_two          PFFFTD_RENAME(pffftd_is_power_of_two)
+#define pffftd_min_fft_size             PFFFTD_RENAME(pffftd_min_fft_size)
+#define pffftd_cplx_finalize            PFFFTD_RENAME(pffftd_cplx_finalize)
+#define pffftd_cplx_preprocess          PFFFTD_RENAME(pffftd_cplx_preprocess)
+#define pffftd_transform_internal       PFFFTD_RENAME(pffftd_transform_internal)
+#define validate_pffftd_simd            PFFFTD_RENAME(validate_pffftd_simd)
+#define validate_pffftd_simd_ex         PFFFTD_RENAME(validate_pffftd_simd_ex)
@@ -59,11 +59,12 @@ class CDSPFIRFilter : public R8B_BASECLASS
 	R8BNOCTOR( CDSPFIRFilter );
 
 	friend class CDSPFIRFilterCache;
+	friend class CSnapshotIndex< CDSPFIRFilter >;
 
 public:
 	~CDSPFIRFilter()
 	{
-		R8BASSERT( RefCount == 0 );
+		R8BASSERT( RefCount <= 0 );
 
 		delete Next;
 	}
@@ -185,7 +186,8 @@ private:
 	EDSPFilterPhaseResponse ReqPhase; ///< Required filter's phase response.
 	double ReqGain; ///< Required overall filter's gain.
 	CDSPFIRFilter* Next; ///< Next FIR filter in cache's list.
-	int RefCount; ///< The number of references made to *this FIR filter.
+	std::atomic< int > RefCount; ///< The number of references made to
+		///< *this FIR filter, -1 if the filter was evicted from the cache.
 	bool IsZeroPhase; ///< "True" if kernel block of *this filter has
 		///< zero-phase response.
 	int Latency; ///< Filter's latency in samples (integer part).
@@ -597,6 +599,29 @@ public:
 		R8BASSERT( ReqAtten <= CDSPFIRFilter :: getLPMaxAtten() );
 		R8BASSERT( ReqGain > 0.0 );
 
+		// Look up an already built filter without locking; filters evicted
+		// in the meantime cannot be referenced, and are looked up again
+		// below.
+
+		CDSPFIRFilter* const FoundObj = Index.find(
+			[&]( const CDSPFIRFilter& f )
+			{
+				return( f.ReqNormFreq == ReqNormFreq &&
+					f.ReqTransBand == ReqTransBand &&
+					f.ReqGain == ReqGain &&
+					f.ReqAtten == ReqAtten &&
+					f.ReqPhase == ReqPhase );
+			},
+			[]( CDSPFIRFilter& f )
+			{
+				return( tryAddRef( f.RefCount ));
+			});
+
+		if( FoundObj != NULL )
+		{
+			return( *FoundObj );
+		}
+
 		R8BSYNC( StateSync );
 
 		CDSPFIRFilter* PrevObj = NULL;
@@ -615,12 +640,13 @@ public:
 
 			if( CurObj -> Next == NULL && ObjCount >= R8B_FILTER_CACHE_MAX )
 			{
-				if( CurObj -> RefCount == 0 )
+				if( tryRetireRef( CurObj -> RefCount ))
 				{
-					// Delete the last filter which is not used.
+					// Delete the last filter which is not used, once no
+					// lock-free lookup can reach it.
 
 					PrevObj -> Next = NULL;
-					delete CurObj;
+					Index.retire( CurObj );
 					ObjCount--;
 				}
 				else
@@ -675,6 +701,9 @@ public:
 		CurObj -> Next = Objects.unkeep();
 		Objects = CurObj;
 
+		Index.publish( Objects );
+		Index.collect();
+
 		return( *CurObj );
 	}
 
@@ -682,6 +711,8 @@ private:
 	static CSyncObject StateSync; ///< Cache state synchronizer.
 	static CPtrKeeper< CDSPFIRFilter* > Objects; ///< The chain of cached
 		///< objects.
+	static CSnapshotIndex< CDSPFIRFilter > Index; ///< Lock-free lookup
+		///< index of the chain of cached objects.
 	static int ObjCount; ///< The number of objects currently preset in the
 		///< cache.
 };
@@ -692,8 +723,6 @@ private:
 
 inline void CDSPFIRFilter :: unref()
 {
-	R8BSYNC( CDSPFIRFilterCache :: StateSync );
-
 	RefCount--;
 }
 
@@ -39,6 +39,7 @@ class CDSPFracDelayFilterBank : public R8B_BASECLASS
 	R8BNOCTOR( CDSPFracDelayFilterBank );
 
 	friend class CDSPFracDelayFilterBankCache;
+	friend class CSnapshotIndex< CDSPFracDelayFilterBank >;
 
 public:
 	/**
@@ -260,8 +261,9 @@ private:
 		///< for all discrete fractional x = 0..1 sample positions, and
 		///< interpolation coefficients.
 	CDSPFracDelayFilterBank* Next; ///< Next filter bank in cache's list.
-	int RefCount; ///< The number of references made to *this filter bank.
-		///< Not considered for "static" filter bank objects.
+	std::atomic< int > RefCount; ///< The number of references made to *this
+		///< filter bank, -1 if the bank was evicted from the cache. Not
+		///< considered for "static" filter bank objects.
 
 	/**
 	 * Function returns windowing function parameters for the specified
@@ -456,6 +458,32 @@ public:
 	{
 		CDSPFracDelayFilterBank :: roundReqAtten( ReqAtten, IsThird );
 
+		// Look up an already built bank without locking; banks evicted in
+		// the meantime cannot be referenced, and are looked up again below.
+
+		const auto IsMatch = [&]( const CDSPFracDelayFilterBank& b )
+		{
+			return( b.InitFilterFracs == aFilterFracs &&
+				b.IsThird == IsThird &&
+				b.ElementSize == aElementSize &&
+				b.InterpPoints == aInterpPoints &&
+				b.ReqAtten == ReqAtten );
+		};
+
+		CDSPFracDelayFilterBank* const FoundObj = ( IsStatic ?
+			StaticIndex.find( IsMatch,
+				[]( CDSPFracDelayFilterBank& ) { return( true ); }) :
+			Index.find( IsMatch,
+				[]( CDSPFracDelayFilterBank& b )
+				{
+					return( tryAddRef( b.RefCount ));
+				}));
+
+		if( FoundObj != NULL )
+		{
+			return( *FoundObj );
+		}
+
 		R8BSYNC( StateSync );
 
 		if( IsStatic )
@@ -497,6 +525,9 @@ public:
 			CurObj -> Next = StaticObjects.unkeep();
 			StaticObjects = CurObj;
 
+			StaticIndex.publish( StaticObjects );
+			StaticIndex.collect();
+
 			return( *CurObj );
 		}
 
@@ -516,12 +547,13 @@ public:
 
 			if( CurObj -> Next == NULL && ObjCount >= R8B_FRACBANK_CACHE_MAX )
 			{
-				if( CurObj -> RefCount == 0 )
+				if( tryRetireRef( CurObj -> RefCount ))
 				{
-					// Delete the last bank which is not used.
+					// Delete the last bank which is not used, once no
+					// lock-free lookup can reach it.
 
 					PrevObj -> Next = NULL;
-					delete CurObj;
+					Index.retire( CurObj );
 					ObjCount--;
 				}
 				else
@@ -570,6 +602,9 @@ public:
 		CurObj -> Next = Objects.unkeep();
 		Objects = CurObj;
 
+		Index.publish( Objects );
+		Index.collect();
+
 		return( *CurObj );
 	}
 
@@ -579,6 +614,10 @@ private:
 		///< cached objects.
 	static CPtrKeeper< CDSPFracDelayFilterBank* > StaticObjects; ///< The
 		///< chain of static objects.
+	static CSnapshotIndex< CDSPFracDelayFilterBank > Index; ///< Lock-free
+		///< lookup index of the Objects chain.
+	static CSnapshotIndex< CDSPFracDelayFilterBank > StaticIndex; ///<
+		///< Lock-free lookup index of the StaticObjects chain.
 	static int ObjCount; ///< The number of objects currently preset in the
 		///< Objects cache.
 };
@@ -589,8 +628,6 @@ private:
 
 inline void CDSPFracDelayFilterBank :: unref()
 {
-	R8BSYNC( CDSPFracDelayFilterBankCache :: StateSync );
-
 	RefCount--;
 }
 
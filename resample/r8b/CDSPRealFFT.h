@@ -628,15 +628,72 @@ private:
 		///< various lengths.
 
 	/**
-	 * Function acquires FFT object from the global pool.
+	 * @brief Per-thread FFT object cache.
+	 *
+	 * Holds at most one FFT object of each length, so that a thread which
+	 * repeatedly acquires and releases FFT objects does not contend for the
+	 * global pool. Cached objects are returned to the global pool when the
+	 * thread exits.
+	 */
+
+	class CThreadCache
+	{
+		R8BNOCTOR( CThreadCache );
+
+	public:
+		CThreadCache()
+		{
+			memset( Objects, 0, sizeof( Objects ));
+		}
+
+		~CThreadCache()
+		{
+			int i;
+
+			for( i = 0; i < 31; i++ )
+			{
+				if( Objects[ i ] != NULL )
+				{
+					releaseGlobal( Objects[ i ]);
+				}
+			}
+		}
+
+		CDSPRealFFT* Objects[ 31 ]; ///< Cached objects, indexed by LenBits.
+	};
+
+	/**
+	 * @return The calling thread's FFT object cache.
+	 */
+
+	static CThreadCache& getThreadCache()
+	{
+		static thread_local CThreadCache Cache;
+
+		return( Cache );
+	}
+
+	/**
+	 * Function acquires FFT object from the calling thread's cache, or from
+	 * the global pool.
 	 *
 	 * @param LenBits FFT block length (expressed as Nth power of 2).
 	 */
 
-	CDSPRealFFT* acquire( const int LenBits )
+	static CDSPRealFFT* acquire( const int LenBits )
 	{
 		R8BASSERT( LenBits > 0 && LenBits <= 30 );
 
+		CThreadCache& tc = getThreadCache();
+		CDSPRealFFT* const cached = tc.Objects[ LenBits ];
+
+		if( cached != NULL )
+		{
+			tc.Objects[ LenBits ] = NULL;
+
+			return( cached );
+		}
+
 		R8BSYNC( StateSync );
 
 		if( FFTObjects[ LenBits ] == NULL )
@@ -651,12 +708,35 @@ private:
 	}
 
 	/**
-	 * Function releases a previously acquired FFT object.
+	 * Function releases a previously acquired FFT object to the calling
+	 * thread's cache, or to the global pool if the cache already holds an
+	 * object of the same length.
+	 *
+	 * @param ffto FFT object to release.
+	 */
+
+	static void release( CDSPRealFFT* const ffto )
+	{
+		CThreadCache& tc = getThreadCache();
+
+		if( tc.Objects[ ffto -> LenBits ] == NULL )
+		{
+			ffto -> Next = NULL;
+			tc.Objects[ ffto -> LenBits ] = ffto;
+
+			return;
+		}
+
+		releaseGlobal( ffto );
+	}
+
+	/**
+	 * Function releases a previously acquired FFT object to the global pool.
 	 *
 	 * @param ffto FFT object to release.
 	 */
 
-	void release( CDSPRealFFT* const ffto )
+	static void releaseGlobal( CDSPRealFFT* const ffto )
 	{
 		R8BSYNC( StateSync );
 
@@ -28,11 +28,14 @@ CDSPRealFFT :: CObjKeeper CDSPRealFFTKeeper :: FFTObjects[ 31 ];
 
 CSyncObject CDSPFIRFilterCache :: StateSync;
 CPtrKeeper< CDSPFIRFilter* > CDSPFIRFilterCache :: Objects;
+CSnapshotIndex< CDSPFIRFilter > CDSPFIRFilterCache :: Index;
 int CDSPFIRFilterCache :: ObjCount = 0;
 
 CSyncObject CDSPFracDelayFilterBankCache :: StateSync;
 CPtrKeeper< CDSPFracDelayFilterBank* > CDSPFracDelayFilterBankCache :: Objects;
 CPtrKeeper< CDSPFracDelayFilterBank* > CDSPFracDelayFilterBankCache :: StaticObjects;
+CSnapshotIndex< CDSPFracDelayFilterBank > CDSPFracDelayFilterBankCache :: Index;
+CSnapshotIndex< CDSPFracDelayFilterBank > CDSPFracDelayFilterBankCache :: StaticIndex;
 int CDSPFracDelayFilterBankCache :: ObjCount = 0;
 
 } // namespace r8b
@@ -63,6 +63,7 @@
 #include <stdint.h>
 #include <string.h>
 #include <math.h>
+#include <atomic>
 #include "r8bconf.h"
 
 #if defined( _WIN32 )
@@ -666,6 +667,228 @@ private:
 #define R8BSYNC_( SyncObject, id ) R8BSYNC__( SyncObject, id )
 #define R8BSYNC__( SyncObject, id ) CSyncKeeper SyncKeeper##id( SyncObject )
 
+/**
+ * Function increments an object's reference counter, unless the object was
+ * marked as retired by the tryRetireRef() function.
+ *
+ * @param RefCount Reference counter, negative if the object was retired.
+ * @return "True" if the reference was added.
+ */
+
+inline bool tryAddRef( std::atomic< int >& RefCount )
+{
+	int rc = RefCount.load();
+
+	while( rc >= 0 )
+	{
+		if( RefCount.compare_exchange_weak( rc, rc + 1 ))
+		{
+			return( true );
+		}
+	}
+
+	return( false );
+}
+
+/**
+ * Function marks an unreferenced object as retired, so that no new
+ * references can be added to it by the tryAddRef() function.
+ *
+ * @param RefCount Reference counter.
+ * @return "True" if the object had no references and was marked as retired.
+ */
+
+inline bool tryRetireRef( std::atomic< int >& RefCount )
+{
+	int rc = 0;
+
+	return( RefCount.compare_exchange_strong( rc, -1 ));
+}
+
+/**
+ * @brief Lock-free lookup index over a cache's chain of objects.
+ *
+ * Readers search an immutable snapshot of the chain without acquiring the
+ * cache's synchronization object. The owning cache rebuilds the snapshot,
+ * while holding its synchronization object, after each change to the chain.
+ *
+ * Replaced snapshots and objects removed from the chain are not deleted
+ * immediately, but "retired" and deleted once no reader is inside the find()
+ * function, so that a reader never accesses freed memory.
+ *
+ * @tparam T Object type. Must have a "Next" pointer that forms the cache's
+ * chain, and deleting an object must delete its "Next" object.
+ */
+
+template< class T >
+class CSnapshotIndex
+{
+	R8BNOCTOR( CSnapshotIndex );
+
+public:
+	CSnapshotIndex()
+		: Current( NULL )
+		, Readers( 0 )
+		, RetiredSnapshots( NULL )
+		, RetiredObjects( NULL )
+	{
+	}
+
+	~CSnapshotIndex()
+	{
+		delete Current.load();
+		deleteRetired();
+	}
+
+	/**
+	 * Function searches the current snapshot without locking.
+	 *
+	 * @param Pred Predicate that returns "true" for the object being searched
+	 * for.
+	 * @param Acquire Function that references the found object, returns
+	 * "false" if the object cannot be referenced anymore.
+	 * @return The found and referenced object, or NULL if the object was not
+	 * found or could not be referenced.
+	 */
+
+	template< class TPred, class TAcquire >
+	T* find( TPred Pred, TAcquire Acquire )
+	{
+		Readers.fetch_add( 1 );
+
+		const CSnapshot* const s = Current.load();
+		T* Result = NULL;
+
+		if( s != NULL )
+		{
+			int i;
+
+			for( i = 0; i < s -> Count; i++ )
+			{
+				T* const Obj = s -> Objects[ i ];
+
+				if( Pred( *Obj ))
+				{
+					if( Acquire( *Obj ))
+					{
+						Result = Obj;
+					}
+
+					break;
+				}
+			}
+		}
+
+		Readers.fetch_sub( 1 );
+
+		return( Result );
+	}
+
+	/**
+	 * Function publishes a new snapshot of the chain. Should be called while
+	 * holding the cache's synchronization object.
+	 *
+	 * @param Chain The first object of the chain, can be NULL.
+	 */
+
+	void publish( T* const Chain )
+	{
+		int Count = 0;
+		T* Obj = Chain;
+
+		while( Obj != NULL )
+		{
+			Count++;
+			Obj = Obj -> Next;
+		}
+
+		CSnapshot* const s = new CSnapshot( Count );
+		Obj = Chain;
+		Count = 0;
+
+		while( Obj != NULL )
+		{
+			s -> Objects[ Count ] = Obj;
+			Count++;
+			Obj = Obj -> Next;
+		}
+
+		CSnapshot* const Prev = Current.exchange( s );
+
+		if( Prev != NULL )
+		{
+			Prev -> Next = RetiredSnapshots;
+			RetiredSnapshots = Prev;
+		}
+	}
+
+	/**
+	 * Function retires an object already removed from the chain and from
+	 * the published snapshot. Should be called while holding the cache's
+	 * synchronization object.
+	 *
+	 * @param Obj Object to delete when no readers can access it anymore.
+	 */
+
+	void retire( T* const Obj )
+	{
+		Obj -> Next = RetiredObjects;
+		RetiredObjects = Obj;
+	}
+
+	/**
+	 * Function deletes the retired snapshots and objects if no reader is
+	 * active. Should be called while holding the cache's synchronization
+	 * object.
+	 */
+
+	void collect()
+	{
+		if( Readers.load() == 0 )
+		{
+			deleteRetired();
+		}
+	}
+
+private:
+	/**
+	 * Immutable array of the chain's objects.
+	 */
+
+	struct CSnapshot : public R8B_BASECLASS
+	{
+		CSnapshot( const int aCount )
+			: Count( aCount )
+			, Objects( aCount > 0 ? aCount : 1 )
+			, Next( NULL )
+		{
+		}
+
+		~CSnapshot()
+		{
+			delete Next;
+		}
+
+		int Count; ///< The number of objects in the snapshot.
+		CFixedBuffer< T* > Objects; ///< Objects of the chain.
+		CSnapshot* Next; ///< Next retired snapshot.
+	};
+
+	std::atomic< CSnapshot* > Current; ///< The published snapshot.
+	std::atomic< int > Readers; ///< The number of active find() calls.
+	CSnapshot* RetiredSnapshots; ///< Chain of replaced snapshots.
+	T* RetiredObjects; ///< Chain of objects removed from the cache.
+
+	void deleteRetired()
+	{
+		delete RetiredSnapshots;
+		RetiredSnapshots = NULL;
+
+		delete RetiredObjects;
+		RetiredObjects = NULL;
+	}
+};
+
 /**
  * @brief Sine signal generator class.
  *
@@ -6,38 +6,284 @@
 namespace r8b
 {
 
-static juce::AudioBuffer<float> resample(const juce::AudioBuffer<float>& sourceBuffer, double sourceFs, double destFs)
+enum class Quality
 {
-    int numChannels = sourceBuffer.getNumChannels();
-    int sourceLength = sourceBuffer.getNumSamples();
-    int destLength = std::floor(sourceLength * destFs / sourceFs);
+    low = 0,    // 16-bit
+    medium,     // 24-bit
+    high        // library default, used for sample conversion
+};
 
-    // Output buffer
-    juce::AudioBuffer<float> outBuffer;
-    outBuffer.setSize(numChannels, destLength);
+inline double getAttenuation(Quality quality)
+{
+    switch (quality)
+    {
+        case Quality::low:      return 136.45;
+        case Quality::medium:   return 180.15;
+        case Quality::high:     return 206.91;
+    }
+
+    return 206.91;
+}
+
+/**
+    Float-in/float-out wrapper around CDSPResampler.
+
+    The per-channel resamplers and the double scratch buffer are allocated once,
+    so the same object can be reused across calls with the same rate pair and
+    channel count. Input is fed in blocks of at most maxBlockSize samples,
+    converted to double in contiguous runs, and output is written straight to
+    the destination.
+
+    Each channel still has its own CDSPResampler and is filtered on its own, so
+    a stereo buffer costs about twice a mono one. Multi-channel buffers are
+    only walked block by block, advancing every channel by one block before
+    the next, with one scratch buffer between them. Filter design is shared
+    regardless, through r8b's caches.
+
+    Whole buffers can be converted with process(), or a stream can be fed block
+    by block with processBlock() followed by reset() at the end of the stream.
+*/
+class FloatResampler
+{
+public:
+    static constexpr int defaultBlockSize{ 4096 };
+
+    FloatResampler(double sourceFs, double destFs, Quality quality = Quality::high, int maxBlockSize = defaultBlockSize, int numChannels = 1)
+        : _sourceFs(sourceFs),
+          _destFs(destFs),
+          _quality(quality),
+          _blockSize(maxBlockSize),
+          _scratch(size_t(maxBlockSize))
+    {
+        jassert(maxBlockSize > 0);
+        jassert(numChannels > 0);
+
+        // Every channel after the first finds its filters in r8b's caches
+        for (int j = 0; j < numChannels; j++)
+            _resamplers.add(new CDSPResampler(sourceFs, destFs, maxBlockSize, 2.0, getAttenuation(quality)));
+    }
+
+    ~FloatResampler() = default;
+
+    static int getOutputLength(int sourceLength, double sourceFs, double destFs)
+    {
+        return int(std::floor(sourceLength * destFs / sourceFs));
+    }
+
+    double getSourceRate() const { return _sourceFs; }
+    double getDestRate() const { return _destFs; }
+    Quality getQuality() const { return _quality; }
+    int getMaxBlockSize() const { return _blockSize; }
+    int getNumChannels() const { return _resamplers.size(); }
+
+    // Upper bound on the number of samples processBlock() can produce
+    int getMaxOutputLength() { return _resamplers.getFirst()->getMaxOutLen(_blockSize); }
+
+    // Clears the filter state, ready for an unrelated stream
+    void reset()
+    {
+        for (auto* r : _resamplers)
+            r->clear();
+    }
+
+    // Streams numIn <= getMaxBlockSize() samples of one channel, returning the number of samples written to dest
+    int processBlock(const float* source, int numIn, float* dest, int channel = 0)
+    {
+        jassert(numIn <= _blockSize);
+
+        convert(source, _scratch.get(), numIn);
+
+        double* out;
+        auto numOut = _resamplers.getUnchecked(channel)->process(_scratch.get(), numIn, out);
+        convert(out, dest, numOut);
+
+        return numOut;
+    }
+
+    // Resamples one channel, zero-padding the input until destLength samples have been produced
+    void process(const float* source, int sourceLength, float* dest, int destLength)
+    {
+        process(&source, 1, sourceLength, &dest, destLength);
+    }
+
+    // Resamples every channel of source into dest, which must already be sized
+    void process(const juce::AudioBuffer<float>& source, juce::AudioBuffer<float>& dest)
+    {
+        jassert(source.getNumChannels() == dest.getNumChannels());
+
+        process(source.getArrayOfReadPointers(), source.getNumChannels(), source.getNumSamples(),
+                dest.getArrayOfWritePointers(), dest.getNumSamples());
+    }
+
+private:
+    void process(const float* const* source, int numChannels, int sourceLength, float* const* dest, int destLength)
+    {
+        jassert(numChannels <= getNumChannels());
+
+        int inPos = 0, outPos = 0;
+        bool scratchIsZero = false;
+
+        while (outPos < destLength)
+        {
+            auto numIn = juce::jmin(sourceLength - inPos, _blockSize);
+            auto numOut = 0;
 
-    for (int j = 0; j < numChannels; j++)
+            if (numIn <= 0)
+            {
+                numIn = _blockSize;
+
+                if (!scratchIsZero)
+                {
+                    std::fill_n(_scratch.get(), _blockSize, 0.0);
+                    scratchIsZero = true;
+                }
+            }
+
+            // The channels are fed identical block sizes, so they all produce the same output length
+            for (int j = 0; j < numChannels; j++)
+            {
+                if (!scratchIsZero)
+                    convert(source[j] + inPos, _scratch.get(), numIn);
+
+                double* out;
+                numOut = juce::jmin(_resamplers.getUnchecked(j)->process(_scratch.get(), numIn, out), destLength - outPos);
+                convert(out, dest[j] + outPos, numOut);
+            }
+
+            inPos += numIn;
+            outPos += numOut;
+        }
+
+        for (int j = 0; j < numChannels; j++)
+            _resamplers.getUnchecked(j)->clear();
+    }
+
+    // Plain contiguous loops, which the compiler turns into packed conversions
+    template <typename In, typename Out>
+    static void convert(const In* in, Out* out, int numSamples)
     {
-        // Prepare resampler
-        auto resampler = std::make_unique<r8b::CDSPResampler>(sourceFs, destFs, sourceLength);
-        auto numRequired = resampler->getInputRequiredForOutput(destLength);
+        for (int i = 0; i < numSamples; i++)
+            out[i] = Out(in[i]);
+    }
+
+    const double _sourceFs, _destFs;
+    const Quality _quality;
+    const int _blockSize;
 
-        // Convert float source buffer to double to be compatible with resampler
-        juce::AudioBuffer<double> sourceBufferDouble;
-        sourceBufferDouble.setSize(1, numRequired);
-        sourceBufferDouble.clear();
+    juce::OwnedArray<CDSPResampler> _resamplers;
+    juce::HeapBlock<double> _scratch;
 
-        for (int i = 0; i < sourceLength; i++)
-            sourceBufferDouble.setSample(0, i, double(sourceBuffer.getSample(j, i)));
+    JUCE_DECLARE_NON_COPYABLE(FloatResampler)
+};
 
-        // Do resample and save to float output buffer
-        double* outPtr;
-        resampler->process(sourceBufferDouble.getWritePointer(0), numRequired, outPtr);
-        for (int i = 0; i < destLength; i++)
-            outBuffer.setSample(j, i, float(outPtr[i]));
+/**
+    Keeps built resamplers around so that repeated conversions with the same
+    rate pair and quality skip filter design and FFT setup.
+
+    acquire() hands out an idle resampler, or builds one if none is available.
+    The handle returns it to the pool, cleared, when it goes out of scope.
+*/
+class ResamplerPool
+{
+public:
+    static constexpr int defaultMaxNumIdle{ 16 };
+
+    class Handle
+    {
+    public:
+        Handle() = default;
+        Handle(Handle&&) = default;
+
+        ~Handle()
+        {
+            if (_pool != nullptr && _resampler != nullptr)
+                _pool->release(std::move(_resampler));
+        }
+
+        FloatResampler* operator->() const { return _resampler.get(); }
+        FloatResampler& operator*() const { return *_resampler; }
+
+    private:
+        friend class ResamplerPool;
+
+        Handle(ResamplerPool* pool, std::unique_ptr<FloatResampler> resampler)
+            : _pool(pool), _resampler(std::move(resampler)) {}
+
+        ResamplerPool* _pool{ nullptr };
+        std::unique_ptr<FloatResampler> _resampler;
+    };
+
+    ResamplerPool() = default;
+    ~ResamplerPool() = default;
+
+    Handle acquire(double sourceFs, double destFs, Quality quality = Quality::high, int numChannels = 1)
+    {
+        {
+            const juce::ScopedLock sl(_lock);
+
+            // Most recently released resamplers are at the back
+            for (auto it = _idle.rbegin(); it != _idle.rend(); ++it)
+            {
+                auto& r = **it;
+
+                if (r.getSourceRate() == sourceFs && r.getDestRate() == destFs && r.getQuality() == quality
+                    && r.getNumChannels() == numChannels)
+                {
+                    auto resampler = std::move(*it);
+                    _idle.erase(std::next(it).base());
+                    return { this, std::move(resampler) };
+                }
+            }
+        }
+
+        return { this, std::make_unique<FloatResampler>(sourceFs, destFs, quality, FloatResampler::defaultBlockSize, numChannels) };
+    }
+
+    void setMaxNumIdle(int maxNumIdle)
+    {
+        const juce::ScopedLock sl(_lock);
+        _maxNumIdle = maxNumIdle;
+        trim();
+    }
+
+private:
+    void release(std::unique_ptr<FloatResampler> resampler)
+    {
+        resampler->reset();
+
+        const juce::ScopedLock sl(_lock);
+        _idle.push_back(std::move(resampler));
+        trim();
     }
 
-    return std::move(outBuffer);
+    void trim()
+    {
+        // Drop the least recently used resamplers first
+        auto numToRemove = int(_idle.size()) - _maxNumIdle;
+        if (numToRemove > 0)
+            _idle.erase(_idle.begin(), _idle.begin() + numToRemove);
+    }
+
+    juce::CriticalSection _lock;
+    std::vector<std::unique_ptr<FloatResampler>> _idle;
+    int _maxNumIdle{ defaultMaxNumIdle };
+
+    JUCE_DECLARE_NON_COPYABLE(ResamplerPool)
+};
+
+inline juce::AudioBuffer<float> resample(const juce::AudioBuffer<float>& sourceBuffer, double sourceFs, double destFs, Quality quality = Quality::high)
+{
+    auto destLength = FloatResampler::getOutputLength(sourceBuffer.getNumSamples(), sourceFs, destFs);
+
+    // Output buffer
+    juce::AudioBuffer<float> outBuffer{ sourceBuffer.getNumChannels(), destLength };
+
+    // The pool lives as long as something else holds a reference to it
+    juce::SharedResourcePointer<ResamplerPool> pool;
+    auto resampler = pool->acquire(sourceFs, destFs, quality, sourceBuffer.getNumChannels());
+    resampler->process(sourceBuffer, outBuffer);
+
+    return outBuffer;
 }
 
 }